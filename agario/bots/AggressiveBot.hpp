@@ -25,7 +25,11 @@ namespace agario {
       AggressiveBot(agario::pid pid, const std::string &name, agario::color color)
         : Bot(pid, name, color), targeting(bot::no_player) { }
 
-      void take_action(const GameState &state) override {
+      std::shared_ptr<agario::Player<renderable>> clone() const override {
+        return std::make_shared<AggressiveBot>(*this);
+      }
+
+      void take_action(const GameState &state, agario::Rng &rng) override {
 
         auto &largest_cell = this->largest_cell();
 
@@ -48,7 +52,7 @@ namespace agario {
 
         }
 
-        this->chase_pellet(state);
+        this->chase_pellet(state, rng);
       }
 
     private:
@@ -25,7 +25,11 @@ namespace agario {
       AggressiveShyBot(agario::pid pid, const std::string &name, agario::color color)
         : Bot(pid, name, color), targeting(bot::no_player) { }
 
-      void take_action(const GameState &state) override {
+      std::shared_ptr<agario::Player<renderable>> clone() const override {
+        return std::make_shared<AggressiveShyBot>(*this);
+      }
+
+      void take_action(const GameState &state, agario::Rng &rng) override {
 
         // check if there are any big players nearby
         for (auto &pair : state.players) {
@@ -64,7 +68,7 @@ namespace agario {
 
         }
 
-        this->chase_pellet(state);
+        this->chase_pellet(state, rng);
       }
 
     private:
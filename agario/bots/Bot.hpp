@@ -26,11 +26,15 @@ namespace agario {
       explicit Bot(const std::string &name) : Bot(-1, name) {this->is_bot = true;}
       explicit Bot(agario::pid pid) : Bot(pid, "Bot") {this->is_bot = true;}
 
+      std::shared_ptr<agario::Player<renderable>> clone() const override {
+        return std::make_shared<Bot>(*this);
+      }
+
     protected:
 
-      void chase_pellet(const GameState &state) {
+      void chase_pellet(const GameState &state, agario::Rng &rng) {
         this->action = agario::action::none;
-        this->target = this->nearest_pellet(state);
+        this->target = this->nearest_pellet(state, rng);
       }
 
       agario::pid find_target (const GameState &state, const Cell &largest_cell, agario::distance radius) const {
@@ -38,9 +42,10 @@ namespace agario {
         agario::pid target = bot::no_player;
         agario::mass target_mass = 0;
 
+        auto here = this->location();
         for (auto &pair : state.players) {
           auto &player = *pair.second;
-          auto proximity = this->location().distance_to(player.location());
+          auto proximity = here.distance_to(player.location());
           if (proximity < radius) {
             auto mass = this->edible_mass(player, largest_cell);
             if (target == bot::no_player || mass > target_mass) {
@@ -88,13 +93,20 @@ namespace agario {
       }
 
 
+      /* a random location in the arena (at integer coordinates) */
+      static agario::Location random_arena_location(const GameState &state, agario::Rng &rng) {
+        std::uniform_int_distribution<int> x_dist(0, static_cast<int>(state.config.arena_width) - 1);
+        std::uniform_int_distribution<int> y_dist(0, static_cast<int>(state.config.arena_height) - 1);
+        // drawn one at a time, so that the order of the draws doesn't depend on the compiler
+        auto x = agario::distance(x_dist(rng));
+        auto y = agario::distance(y_dist(rng));
+        return agario::Location(x, y);
+      }
+
       /* location of the nearest pellet */
-      agario::Location nearest_pellet(const GameState &state) const {
-        if (state.pellets.empty()) {
-          return agario::Location(
-          std::rand() % static_cast<int>(state.config.arena_width),
-          std::rand() % static_cast<int>(state.config.arena_height));
-        }
+      agario::Location nearest_pellet(const GameState &state, agario::Rng &rng) const {
+        if (state.pellets.empty())
+          return random_arena_location(state, rng);
 
         // 1/10 chance to pick a random pellet
         // if (std::rand() % 10 == 0) {
@@ -109,8 +121,9 @@ namespace agario {
         agario::Location target;
         distance min_distance = agario::distance::max();
 
+        auto here = this->location();
         for (const auto &pellet : state.pellets) {
-          distance dist = pellet.location().distance_to(this->location());
+          distance dist = pellet.location().distance_to(here);
           if (dist < min_distance && dist > 0.01) {
               target = pellet.location();
               min_distance = dist;
@@ -119,10 +132,7 @@ namespace agario {
 
         // If the nearest pellet is at the same location as the bot, adjust the target slightly
         if (min_distance < 0.01) {
-          target += agario::Location( target.x +
-          std::rand() % static_cast<int>(state.config.arena_width),
-          target.y +
-          std::rand() % static_cast<int>(state.config.arena_height));
+          target += target + random_arena_location(state, rng);
         }
 
         return target;
@@ -165,8 +175,9 @@ namespace agario {
       agario::Location nearest_food (const GameState &state) const {
         distance min_distance = agario::distance::max();
         agario::Location target;
+        auto here = this->location();
         for (auto &food : state.foods) {
-          distance dist = food.location().distance_to(this->location());
+          distance dist = food.location().distance_to(here);
           if (dist < min_distance) {
             target = food.location();
             min_distance = dist;
@@ -20,6 +20,10 @@ namespace agario {
       explicit ExampleBot(const std::string &name) : ExampleBot(-1, name) {}
       explicit ExampleBot(agario::pid pid) : ExampleBot(pid, "ExampleBot") {}
 
+      std::shared_ptr<agario::Player<renderable>> clone() const override {
+        return std::make_shared<ExampleBot>(*this);
+      }
+
       /**
        * Example take_action function. This function is called on the bot
        * during every game tick, allowing the bot to act differently
@@ -38,9 +42,16 @@ namespace agario {
        * at this moment. Smart bots use this information to make informed actions
        * such as "go towards the nearest food" or "run away from a big player
        * if they are nearby". This example bot just does nothing and stays where it is.
+       * @param rng this bot's random number generator, seeded from the game's.
+       * Bots that act randomly must draw from it (not std::rand) so that seeded
+       * games are reproducible
+       *
+       * Bots may take their actions concurrently, so they must only read the
+       * game state and write to themselves.
        */
-      void take_action(const GameState<renderable> &state) override {
+      void take_action(const GameState<renderable> &state, agario::Rng &rng) override {
         static_cast<void>(state); // unused
+        static_cast<void>(rng); // unused
 
         // example: do nothing, just stay where you are
         this->action = agario::action::none;  // don't split, don't feed (i.e. do nothing)
@@ -16,9 +16,13 @@ namespace agario {
       explicit HungryBot(const std::string &name) : HungryBot(-1, name) {}
       explicit HungryBot(agario::pid pid) : HungryBot(pid, "HungryBot") {}
 
-      void take_action(const GameState <renderable> &state) override {
+      std::shared_ptr<agario::Player<renderable>> clone() const override {
+        return std::make_shared<HungryBot>(*this);
+      }
+
+      void take_action(const GameState <renderable> &state, agario::Rng &rng) override {
         this->action = agario::action::none;
-        this->target = this->nearest_pellet(state);
+        this->target = this->nearest_pellet(state, rng);
       }
 
     };
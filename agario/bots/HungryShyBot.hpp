@@ -20,7 +20,11 @@ namespace agario {
       explicit HungryShyBot(const std::string &name) : HungryShyBot(-1, name) {}
       explicit HungryShyBot(agario::pid pid) : HungryShyBot(pid, "HungryShyBot") {}
 
-      void take_action(const GameState<renderable> &state) override {
+      std::shared_ptr<agario::Player<renderable>> clone() const override {
+        return std::make_shared<HungryShyBot>(*this);
+      }
+
+      void take_action(const GameState<renderable> &state, agario::Rng &rng) override {
         this->action = agario::action::none; // no splitting or anything
 
         // check if there are any big players nearby
@@ -40,7 +44,7 @@ namespace agario {
         }
 
         // no cells are too close for comfort... forage for foods
-        this->target = this->nearest_pellet(state);
+        this->target = this->nearest_pellet(state, rng);
       }
 
     };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <math.h>
+#include <atomic>
 #include "agario/core/types.hpp"
 
 #define CELL_EAT_MARGIN 1.1
@@ -12,10 +13,12 @@ namespace agario {
   public:
     int id;
     Ball() = delete;
-    static int global_id;
+    // atomic so that separate games may create entities on different threads
+    inline static std::atomic<int> global_id{1};
 
-
-    explicit Ball(const Location &loc) : x(loc.x), y(loc.y) {id = ++global_id;}
+    explicit Ball(const Location &loc) : x(loc.x), y(loc.y) {
+      id = global_id.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
 
     Ball(distance x, distance y) : Ball(Location(x, y)) {
     }
@@ -94,4 +97,3 @@ namespace agario {
   };
 
 }
-int agario::Ball::global_id = 1;
@@ -122,9 +122,8 @@ namespace agario {
     // gotta redeclare all the constructors because of virtual inheritance...
     template<typename Loc, typename Vel>
     Cell(Loc &&loc, Vel &&vel, agario::mass mass) : Ball(loc), Super(loc, vel),
-                            _mass(mass), _can_recombine(false) {
+                            _mass(mass), _recombine_tick(0) {
       set_mass(mass);
-      _recombine_timer = std::chrono::steady_clock::now();
     }
 
     bool operator < (const Cell &other_cell) const
@@ -180,16 +179,14 @@ namespace agario {
 
     void reduce_mass_by_factor(float factor) { set_mass(mass() / factor); }
 
-    bool can_recombine() {
-      if (_can_recombine) return true;
-      _can_recombine = std::chrono::steady_clock::now() >= _recombine_timer;
-      return _can_recombine;
+    /* whether the cell may recombine with its siblings at game tick `now` */
+    bool can_recombine(agario::tick now) const {
+      return now >= _recombine_tick;
     }
 
-    void reset_recombine_timer() {
-      _recombine_timer = std::chrono::steady_clock::now() +
-                         std::chrono::seconds(RECOMBINE_TIMER_SEC);
-      _can_recombine = false;
+    /* prevents the cell from recombining for `duration` ticks after tick `now` */
+    void reset_recombine_timer(agario::tick now, agario::tick duration) {
+      _recombine_tick = now + duration;
     }
 
     /*
@@ -205,11 +202,10 @@ namespace agario {
 
 
     agario::Velocity splitting_velocity;
-    agario::real_time _recombine_timer;
 
   private:
     agario::mass _mass;
-    bool _can_recombine;
+    agario::tick _recombine_tick; // first tick at which the cell can recombine
   };
 
 }
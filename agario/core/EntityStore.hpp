@@ -0,0 +1,364 @@
+#pragma once
+
+#include "agario/core/types.hpp"
+#include "agario/core/utils.hpp"
+#include "agario/core/Entities.hpp"
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+namespace agario {
+
+  /**
+   * Static properties of each kind of (non-cell) entity, which determine
+   * what an EntityStore needs to hold for it: whether it moves, whether its
+   * mass ever changes and whether it counts the foods that hit it.
+   */
+  template<typename Entity> struct entity_traits;
+
+  template<bool r, unsigned N>
+  struct entity_traits<Pellet<r, N>> {
+    static constexpr bool moving = false;
+    static constexpr bool constant_mass = true;
+    static constexpr bool food_hits = false;
+    static constexpr agario::mass initial_mass = PELLET_MASS;
+  };
+
+  template<bool r, unsigned N>
+  struct entity_traits<Food<r, N>> {
+    static constexpr bool moving = true;
+    static constexpr bool constant_mass = true;
+    static constexpr bool food_hits = false;
+    static constexpr agario::mass initial_mass = FOOD_MASS;
+  };
+
+  template<bool r, unsigned N>
+  struct entity_traits<Virus<r, N>> {
+    static constexpr bool moving = true;
+    static constexpr bool constant_mass = false;
+    static constexpr bool food_hits = true;
+    static constexpr agario::mass initial_mass = VIRUS_INITIAL_MASS;
+  };
+
+  /**
+   * Container for all of the pellets, foods or viruses in the game.
+   *
+   * Renderable games need the entity objects themselves (they carry their
+   * own vertex buffers) so they are kept in a plain `std::vector<Entity>`.
+   * Non-renderable games use the structure-of-arrays specialization below.
+   * Both expose the same index-based accessors, which is what the engine
+   * uses, while read-only range-for loops over either work as they would
+   * over a vector of entities.
+   */
+  template<typename Entity, bool renderable>
+  class EntityStore : public std::vector<Entity> {
+  public:
+    using traits = entity_traits<Entity>;
+
+    agario::distance x(int i) const { return (*this)[i].x; }
+    agario::distance y(int i) const { return (*this)[i].y; }
+    agario::Location location(int i) const { return (*this)[i].location(); }
+    agario::Velocity velocity(int i) const { return (*this)[i].velocity; }
+    agario::mass mass(int i) const { return (*this)[i].mass(); }
+    agario::distance radius(int i) const { return (*this)[i].radius(); }
+    int food_hits(int i) const { return (*this)[i].get_num_food_hits(); }
+
+    void set_location(int i, agario::distance x, agario::distance y) {
+      (*this)[i].x = x;
+      (*this)[i].y = y;
+    }
+
+    void set_velocity(int i, const agario::Velocity &vel) { (*this)[i].velocity = vel; }
+    void set_mass(int i, agario::mass mass) { (*this)[i].set_mass(mass); }
+    void set_food_hits(int i, int hits) { (*this)[i].set_num_food_hits(hits); }
+
+    /* O(1) removal of entity `i`, moving the last entity into its place */
+    void swap_remove(int i) {
+      std::swap((*this)[i], this->back());
+      this->pop_back();
+    }
+
+    /**
+     * replaces the entities with `n` entities whose fields are given as
+     * arrays (the velocities of kinds that don't move and the masses of
+     * kinds with a constant mass may be null, and are then ignored)
+     */
+    void assign(std::size_t n, const float *x, const float *y,
+                const float *vx = nullptr, const float *vy = nullptr, const agario::mass *mass = nullptr) {
+      this->clear();
+      this->reserve(n);
+      for (std::size_t i = 0; i < n; i++) {
+        if constexpr (traits::moving)
+          this->emplace_back(Location(x[i], y[i]), vx ? Velocity(distance(vx[i]), distance(vy[i])) : Velocity());
+        else
+          this->emplace_back(Location(x[i], y[i]));
+        if constexpr (!traits::constant_mass)
+          if (mass) this->back().set_mass(mass[i]);
+      }
+    }
+
+    /* removes (in order) every entity `i` for which `pred(i)`, returning how many were removed */
+    template<typename Pred>
+    int remove_if(Pred &&pred) {
+      int n = static_cast<int>(this->size());
+      int kept = 0;
+      for (int i = 0; i < n; i++) {
+        if (pred(i)) continue;
+        if (kept != i) std::swap((*this)[kept], (*this)[i]);
+        kept++;
+      }
+      this->erase(this->begin() + kept, this->end());
+      return n - kept;
+    }
+  };
+
+  /**
+   * Structure-of-arrays store for non-renderable games. Each field lives in
+   * its own contiguous array and only the fields that vary for this kind of
+   * entity are stored at all: pellets are just an x and a y, foods add a
+   * velocity, and viruses add a mass, a cached radius and a food hit count.
+   * Constant-mass kinds report a radius computed once for the whole kind,
+   * so nothing on the collision paths goes through a virtual call or a sqrt.
+   */
+  template<typename Entity>
+  class EntityStore<Entity, false> {
+  public:
+    using traits = entity_traits<Entity>;
+
+    /* a copy of a single entity, standing in for `Entity` in read-only code */
+    class View {
+    public:
+      agario::distance x, y;
+      agario::Velocity velocity;
+
+      agario::Location location() const { return Location(x, y); }
+      agario::mass mass() const { return mass_; }
+      agario::distance radius() const { return radius_; }
+      int get_num_food_hits() const { return food_hits_; }
+      float speed() const { return velocity.speed(); }
+
+    private:
+      agario::mass mass_ = 0;
+      agario::distance radius_;
+      int food_hits_ = 0;
+
+      friend class EntityStore;
+    };
+
+    /* iterates over Views of the entities, in index order */
+    class const_iterator {
+    public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = View;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const View *;
+      using reference = const View &;
+
+      const_iterator(const EntityStore *store, int i) : store_(store), i_(i) { }
+
+      reference operator*() const {
+        view_ = (*store_)[i_];
+        return view_;
+      }
+
+      pointer operator->() const { return &**this; }
+
+      const_iterator &operator++() {
+        ++i_;
+        return *this;
+      }
+
+      const_iterator operator++(int) {
+        const_iterator prev = *this;
+        ++i_;
+        return prev;
+      }
+
+      bool operator==(const const_iterator &other) const { return i_ == other.i_; }
+      bool operator!=(const const_iterator &other) const { return i_ != other.i_; }
+
+    private:
+      const EntityStore *store_;
+      int i_;
+      mutable View view_;
+    };
+
+    using iterator = const_iterator;
+
+    std::size_t size() const { return x_.size(); }
+    bool empty() const { return x_.empty(); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, static_cast<int>(size())); }
+
+    View operator[](int i) const {
+      View view;
+      view.x = x_[i];
+      view.y = y_[i];
+      view.velocity = velocity(i);
+      view.mass_ = mass(i);
+      view.radius_ = radius(i);
+      view.food_hits_ = food_hits(i);
+      return view;
+    }
+
+    View front() const { return (*this)[0]; }
+    View back() const { return (*this)[static_cast<int>(size()) - 1]; }
+
+    agario::distance x(int i) const { return x_[i]; }
+    agario::distance y(int i) const { return y_[i]; }
+    agario::Location location(int i) const { return Location(x_[i], y_[i]); }
+
+    agario::Velocity velocity(int i) const {
+      if constexpr (traits::moving) return Velocity(vx_[i], vy_[i]);
+      else return Velocity();
+    }
+
+    agario::mass mass(int i) const {
+      if constexpr (traits::constant_mass) return traits::initial_mass;
+      else return mass_[i];
+    }
+
+    agario::distance radius(int i) const {
+      if constexpr (traits::constant_mass) return constant_radius;
+      else return radius_[i];
+    }
+
+    int food_hits(int i) const {
+      if constexpr (traits::food_hits) return food_hits_[i];
+      else return 0;
+    }
+
+    void set_location(int i, agario::distance x, agario::distance y) {
+      x_[i] = x;
+      y_[i] = y;
+    }
+
+    void set_velocity(int i, const agario::Velocity &vel) {
+      static_assert(traits::moving, "entity does not move");
+      vx_[i] = vel.dx;
+      vy_[i] = vel.dy;
+    }
+
+    void set_mass(int i, agario::mass mass) {
+      static_assert(!traits::constant_mass, "entity has a constant mass");
+      mass_[i] = mass;
+      radius_[i] = radius_conversion(mass);
+    }
+
+    void set_food_hits(int i, int hits) {
+      static_assert(traits::food_hits, "entity does not count food hits");
+      food_hits_[i] = hits;
+    }
+
+    void emplace_back(const agario::Location &loc) { emplace_back(loc, Velocity()); }
+
+    void emplace_back(const agario::Location &loc, const agario::Velocity &vel) {
+      x_.push_back(loc.x);
+      y_.push_back(loc.y);
+      if constexpr (traits::moving) {
+        vx_.push_back(vel.dx);
+        vy_.push_back(vel.dy);
+      }
+      if constexpr (!traits::constant_mass) {
+        mass_.push_back(traits::initial_mass);
+        radius_.push_back(constant_radius);
+      }
+      if constexpr (traits::food_hits)
+        food_hits_.push_back(0);
+    }
+
+    /* O(1) removal of entity `i`, moving the last entity into its place */
+    void swap_remove(int i) {
+      _for_each_field([i](auto &field) {
+        field[i] = field.back();
+        field.pop_back();
+      });
+    }
+
+    void pop_back() {
+      _for_each_field([](auto &field) { field.pop_back(); });
+    }
+
+    /* removes (in order) every entity `i` for which `pred(i)`, returning how many were removed */
+    template<typename Pred>
+    int remove_if(Pred &&pred) {
+      int n = static_cast<int>(size());
+      int kept = 0;
+      for (int i = 0; i < n; i++) {
+        if (pred(i)) continue;
+        if (kept != i)
+          _for_each_field([kept, i](auto &field) { field[kept] = field[i]; });
+        kept++;
+      }
+      _for_each_field([kept](auto &field) { field.resize(kept); });
+      return n - kept;
+    }
+
+    void reserve(std::size_t n) {
+      _for_each_field([n](auto &field) { field.reserve(n); });
+    }
+
+    /* bulk replaces the entities, as in the renderable store's `assign` */
+    void assign(std::size_t n, const float *x, const float *y,
+                const float *vx = nullptr, const float *vy = nullptr, const agario::mass *mass = nullptr) {
+      x_.assign(x, x + n);
+      y_.assign(y, y + n);
+      if constexpr (traits::moving) {
+        if (vx) {
+          vx_.assign(vx, vx + n);
+          vy_.assign(vy, vy + n);
+        } else {
+          vx_.assign(n, 0);
+          vy_.assign(n, 0);
+        }
+      }
+      if constexpr (!traits::constant_mass) {
+        if (mass) {
+          mass_.assign(mass, mass + n);
+          radius_.resize(n);
+          for (std::size_t i = 0; i < n; i++)
+            radius_[i] = radius_conversion(mass_[i]);
+        } else {
+          mass_.assign(n, traits::initial_mass);
+          radius_.assign(n, constant_radius);
+        }
+      }
+      if constexpr (traits::food_hits)
+        food_hits_.assign(n, 0);
+    }
+
+    void clear() {
+      _for_each_field([](auto &field) { field.clear(); });
+    }
+
+  private:
+    // radius of every entity of a constant-mass kind (and the initial radius of the others)
+    inline static const agario::distance constant_radius = radius_conversion(traits::initial_mass);
+
+    std::vector<agario::distance> x_, y_;
+    std::vector<agario::distance> vx_, vy_;   // moving kinds only
+    std::vector<agario::mass> mass_;          // variable-mass kinds only
+    std::vector<agario::distance> radius_;    // cached radius_conversion(mass_)
+    std::vector<int> food_hits_;              // only for kinds that count food hits
+
+    /* applies `f` to every array in use by this kind of entity */
+    template<typename F>
+    void _for_each_field(F &&f) {
+      f(x_);
+      f(y_);
+      if constexpr (traits::moving) {
+        f(vx_);
+        f(vy_);
+      }
+      if constexpr (!traits::constant_mass) {
+        f(mass_);
+        f(radius_);
+      }
+      if constexpr (traits::food_hits)
+        f(food_hits_);
+    }
+  };
+
+}
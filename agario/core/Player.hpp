@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <algorithm>
 #include <vector>
@@ -10,6 +11,7 @@
 #include "agario/core/Entities.hpp"
 #include "agario/core/settings.hpp"
 #include "agario/core/utils.hpp"
+#include "agario/utils/random.hpp"
 
 #include <assert.h>
 #include <type_traits>
@@ -99,22 +101,20 @@ class Player {
 
     void increment_score(score inc) { _score += inc; }
 
-    agario::distance x() const {
-      agario::distance x_ = 0;
-      for (auto &cell : cells)
-        x_ += cell.x * cell.mass();
-      return x_ / mass();
-    }
-
-    agario::distance y() const {
-      agario::distance y_ = 0;
-      for (auto &cell : cells)
-        y_ += cell.y * cell.mass();
-      return y_ / mass();
-    }
+    agario::distance x() const { return location().x; }
+    agario::distance y() const { return location().y; }
 
+    /* center of mass of the player's cells, in a single pass over them */
     agario::Location location() const {
-      return agario::Location(x(), y());
+      agario::distance x_ = 0, y_ = 0;
+      agario::mass total_mass = 0;
+      for (auto &cell : cells) {
+        auto cell_mass = cell.mass();
+        x_ += cell.x * cell_mass;
+        y_ += cell.y * cell_mass;
+        total_mass += cell_mass;
+      }
+      return agario::Location(x_ / total_mass, y_ / total_mass);
     }
 
     // Total mass of the player (sum of masses of all cells)
@@ -157,11 +157,20 @@ class Player {
         cell.draw(shader);
     }
 
-    /* override this function to define a bot's behavior */
-    virtual void take_action(const GameState<renderable> &state) {
+    /**
+     * override this function to define a bot's behavior. Any randomness
+     * must be drawn from `rng` (seeded from the game's generator) for games
+     * to be reproducible from their seed. Players may take their actions
+     * concurrently, so they must only read `state` and write to themselves.
+     */
+    virtual void take_action(const GameState<renderable> &state, agario::Rng &rng) {
       static_cast<void>(state);
+      static_cast<void>(rng);
     }
 
+    /* a deep copy of the player, of the same (bot) type. Bots with their own state must override this */
+    virtual std::shared_ptr<Player> clone() const { return std::make_shared<Player>(*this); }
+
 
     template <bool r = renderable>
     typename std::enable_if<r, void>::type
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "agario/utils/random.hpp"
+
 namespace agario {
   enum color { red, orange, yellow, green, blue, purple, last };
 
@@ -12,7 +14,8 @@ namespace agario {
   float black_color[] = {0.0, 0.0, 0.0};
 
   agario::color random_color() {
-    return static_cast<enum color>(rand() % agario::color::last);
+    std::uniform_int_distribution<int> dist(0, agario::color::last - 1);
+    return static_cast<enum color>(dist(agario::thread_rng()));
   }
 
 }
\ No newline at end of file
@@ -30,6 +30,18 @@
 #define DEFAULT_NUM_VIRUSES 10
 #define PLAYER_CELL_LIMIT 14
 
+// most passes made over a player's cells each tick to push apart those that overlap
+#define SELF_COLLISION_ITERATIONS 5
+
+// side length of the buckets of the spatial indexes over pellets, foods and viruses
+#define SPATIAL_HASH_BUCKET_SIZE 32
+
+// ticks between regenerating the pellets and viruses that have been eaten
+#define REGEN_INTERVAL_TICKS 120
+
+// most pellets and viruses regenerated in a single tick (0 for no limit)
+#define DEFAULT_REGEN_BUDGET 0
+
 //split condition
 #define NUM_CELLS_TO_SPLIT PLAYER_CELL_LIMIT
 #define MIN_CELL_SPLIT_MASS 130
@@ -2,11 +2,13 @@
 
 #include <vector>
 #include <cstdlib>
+#include <cstring>
 #include <chrono>
 #include <algorithm>
 #include <sstream>
 #include<set>
 #include <numeric>
+#include <limits>
 #include <fstream>
 #include<random>
 #include "agario/core/Player.hpp"
@@ -14,9 +16,13 @@
 #include "agario/core/types.hpp"
 #include "agario/core/Entities.hpp"
 #include "agario/engine/GameState.hpp"
+#include "agario/engine/modes.hpp"
 #include "agario/utils/random.hpp"
-#include "agario/utils/collision_detection.hpp"
+#include "agario/utils/sweep_and_prune.hpp"
+#include "agario/utils/profiler.hpp"
+#include "agario/utils/work_pool.hpp"
 #include "agario/utils/json.hpp"
+#include "agario/utils/snapshot.hpp"
 #include <agario/bots/bots.hpp>
 #include <thread>
 #include <chrono>
@@ -26,8 +32,19 @@ namespace agario {
     using runtime_error::runtime_error;
   };
 
-  template<bool renderable>
+  /* access to single phases of the tick, for the benchmarks and tests (see engine/internals.hpp) */
+  struct EngineInternals;
+
+  /**
+   * The game engine. With `profiled` set, every tick records the time spent
+   * (and allocations made) in each of its phases, as well as collision
+   * candidate counts, in `profile()`. Without it, none of the
+   * instrumentation is compiled in.
+   */
+  template<bool renderable, bool profiled = false>
   class Engine {
+    friend struct agario::EngineInternals;
+
   public:
     using Player = Player<renderable>;
     using Cell = Cell<renderable>;
@@ -46,16 +63,15 @@ namespace agario {
       state(agario::GameConfig(arena_width, arena_height, num_pellets, num_viruses, pellet_regen))
     {
       set_mode(mode_number);
-      std::srand(std::chrono::system_clock::now().time_since_epoch().count());
     }
     Engine() : Engine(DEFAULT_ARENA_WIDTH, DEFAULT_ARENA_HEIGHT) {}
 
     /* the number of ticks that have elapsed in the game */
     agario::tick ticks() const { return state.ticks; }
     const typename GameState::PlayerMap &players() const { return state.players; }
-    const std::vector<Pellet> &pellets() const { return state.pellets; }
-    const std::vector<Food> &foods() const { return state.foods; }
-    const std::vector<Virus> &viruses() const { return state.viruses; }
+    const typename GameState::Pellets &pellets() const { return state.pellets; }
+    const typename GameState::Foods &foods() const { return state.foods; }
+    const typename GameState::Viruses &viruses() const { return state.viruses; }
     agario::GameState<renderable> &game_state() { return state; }
     const agario::GameState<renderable> &get_game_state() const { return state; }
     agario::distance arena_width() const { return state.config.arena_width; }
@@ -97,6 +113,8 @@ namespace agario {
 
     void reset() {
       state.clear();
+      if (low_discrepancy_spawns_)
+        state.spawn_sequence.seed(state.rng());
       initialize_game();
     }
 
@@ -105,11 +123,10 @@ namespace agario {
       state.ticks = 0;
       state.next_pid = 0;
       state.main_agent_pid = -1;
-      state.rng.seed(std::random_device{}());
     }
 
     void initialize_game() {
-      if(is_squared_pellets_ == true)
+      if (mode_.squared_pellets)
         create_squared_pellets(state.config.target_num_pellets);
       else
         add_pellets(state.config.target_num_pellets);
@@ -118,11 +135,11 @@ namespace agario {
 
     void respawn(Player &player) {
       player.kill();
-      int player_mass = std::max(CELL_MIN_SIZE, agent_mass); //agent_mass is the mass of the agent.
+      int player_mass = std::max(CELL_MIN_SIZE, mode_.agent_mass); //agent_mass is the mass of the agent.
       if (!state.pellets.empty()) {
-       if(is_squared_pellets_ == true){
+       if (mode_.squared_pellets) {
         auto random_index = 0;
-        auto loc = state.pellets[random_index].location();
+        auto loc = state.pellets.location(random_index);
         loc.x += 2*agario::radius_conversion(CELL_MIN_SIZE);
         loc.y += 2*agario::radius_conversion(CELL_MIN_SIZE);
         loc.x = std::min(loc.x, arena_width() - agario::radius_conversion(CELL_MIN_SIZE));
@@ -147,56 +164,61 @@ namespace agario {
       return Location(x, y);
     }
 
-    void players_collision()
-    {
-      // to change the hierarchy of: I want pair of player_id and cells: Keep in mind that we will std::move cells
-      std::vector<std::pair<agario::pid, Cell>> cells_per_player;
-
-      for(auto &pair : state.players) {
+    /**
+     * Finds every cell that is eaten by a cell of another player and moves
+     * its mass to the cell that ate it. Candidate pairs come from a sweep
+     * over all cells that persists between ticks. A cell that is eaten
+     * cannot eat another cell in the same tick.
+     */
+    void players_collision() {
+      cell_refs_.clear();
+      cell_broadphase_.clear();
+      for (auto &pair : state.players) {
         auto &player = *pair.second;
-        sort(player.cells.begin(), player.cells.end());
-        for(auto &cell : player.cells) {
-          cells_per_player.emplace_back(std::make_pair(player.pid(), std::move(cell)));
+        for (int c = 0; c < static_cast<int>(player.cells.size()); c++) {
+          cell_refs_.emplace_back(&player, c);
+          cell_broadphase_.add(player.cells[c].x, player.cells[c].radius());
         }
       }
 
-      //change
-      PrecisionCollisionDetection<renderable> pcd({arena_width(), arena_height()}, 100);
-      //send the cells for each player
-      auto results = pcd.solve(cells_per_player, cells_per_player);
-
-      for (const auto& result : results) {
-        const auto& id = result.first;
-        const auto& cells = result.second;
-        for (const auto& vect_id : cells) {
-          auto &eaten_player = get_player(vect_id.first);
-          const auto& cell = vect_id.second;
-          auto &player = get_player(cells_per_player[id].first);
-          auto& eaten_player_cells = eaten_player.cells;
-          auto it = std::lower_bound(player.cells.begin(), player.cells.end(), cells_per_player[id].second.id, [](const Cell& c, int id) {
-            return c.id < id;
-          });
-
-          if (it != player.cells.end()) {
-            it->increment_mass(cell.mass());
-            player.cells_eaten++;
-          }
-
-          auto eaten_it = std::lower_bound(eaten_player_cells.begin(), eaten_player_cells.end(), cell.id, [](const Cell& c, int id) {
-            return c.id < id;
-          });
-
-          if (eaten_it != eaten_player_cells.end()) {
-            eaten_player_cells.erase(eaten_it);
-          }
+      cell_eats_.clear();
+      cell_broadphase_.for_each_overlap([&](int a, int b) {
+        profiler_.count(profile::cell_candidates);
+        if (cell_refs_[a].first == cell_refs_[b].first) return;
+        const Cell &cell_a = cell_at(a);
+        const Cell &cell_b = cell_at(b);
+        if (!cell_a.collides_with(cell_b)) return;
+        if (cell_a.can_eat(cell_b))
+          cell_eats_.emplace_back(a, b);
+        else if (cell_b.can_eat(cell_a))
+          cell_eats_.emplace_back(b, a);
+      });
+      if (cell_eats_.empty()) return;
+
+      // resolve in a fixed order so the outcome doesn't depend on the sweep
+      std::sort(cell_eats_.begin(), cell_eats_.end());
+      cell_eaten_.assign(cell_refs_.size(), false);
+      for (auto &[eater, eaten] : cell_eats_) {
+        if (cell_eaten_[eater] || cell_eaten_[eaten]) continue;
+        cell_at(eater).increment_mass(cell_at(eaten).mass());
+        cell_refs_[eater].first->cells_eaten++;
+        cell_eaten_[eaten] = true;
+      }
 
+      // cells of each player are contiguous in cell_refs_, in order
+      int offset = 0;
+      for (auto &pair : state.players) {
+        auto &cells = pair.second->cells;
+        int num_cells = cells.size();
+        int kept = 0;
+        for (int c = 0; c < num_cells; c++) {
+          if (cell_eaten_[offset + c]) continue;
+          if (kept != c) cells[kept] = std::move(cells[c]);
+          kept++;
         }
+        cells.erase(cells.begin() + kept, cells.end());
+        offset += num_cells;
       }
-
-      // do the collision part here:
-      // check_player_collisions();
-
-      cells_per_player.clear();
     }
 
     /**
@@ -206,50 +228,119 @@ namespace agario {
      * since the previous game tick.
      */
     void tick(const agario::time_delta &elapsed_seconds) {
-      // initalize the pellet_grid
-      initialize_pellet_grid();
-      initialize_virus_grid();
-      std::vector<int> pellets_to_remove;
-      std::vector<int> viruses_to_remove;
-      for (auto &pair : state.players) {
-        auto &player = *pair.second;
-        if (!player.dead())
-          tick_player(player, elapsed_seconds, pellets_to_remove, viruses_to_remove);
-      }
-
-      // remove pellets that have been eaten
-      remove_pellets(pellets_to_remove);
-      remove_viruses(viruses_to_remove);
-      pellets_grid.clear();
-      virus_grid.clear();
-
-      players_collision();
+      // pick the tick compiled for the mode's rules (see modes.hpp)
+      if (mode_.mass_decay && mode_.regen_pellets)
+        _tick<mode::Standard>(elapsed_seconds);
+      else if (mode_.mass_decay)
+        _tick<mode::NoRegen>(elapsed_seconds);
+      else if (mode_.regen_pellets)
+        _tick<mode::NoDecay>(elapsed_seconds);
+      else
+        _tick<mode::NoDecayNoRegen>(elapsed_seconds);
+    }
 
-      move_foods(elapsed_seconds);
+    /**
+     * a 64-bit FNV-1a hash of the game: the tick count, the RNG state and
+     * the position, velocity and mass of every cell and entity. Equal games
+     * have equal hashes, so comparing them detects when two runs diverge.
+     */
+    std::uint64_t state_hash() const {
+      std::uint64_t hash = 0xcbf29ce484222325ull;
+      auto mix = [&hash](auto value) {
+        unsigned char bytes[sizeof(value)];
+        std::memcpy(bytes, &value, sizeof(value));
+        for (auto byte : bytes) {
+          hash ^= byte;
+          hash *= 0x100000001b3ull;
+        }
+      };
 
-      if(regen_pellets){ // if there is regeneration to the pellets.
-        if(state.ticks%120 == 0){ //every 6 seconds
-          // if (state.config.pellet_regen) {
-            add_pellets(state.config.target_num_pellets - state.pellets.size());
-          // }
-            add_viruses(state.config.target_num_viruses - state.viruses.size());
+      mix(static_cast<std::uint64_t>(state.ticks));
+      for (auto word : state.rng.state()) mix(word);
+      for (auto &[pid, player] : state.players) {
+        mix(pid);
+        for (auto &cell : player->cells) {
+          mix(static_cast<float>(cell.x));
+          mix(static_cast<float>(cell.y));
+          mix(static_cast<float>(cell.velocity.dx));
+          mix(static_cast<float>(cell.velocity.dy));
+          mix(cell.mass());
         }
       }
-      state.ticks++;
-
+      auto mix_entities = [&mix](const auto &store) {
+        for (int i = 0; i < static_cast<int>(store.size()); i++) {
+          mix(static_cast<float>(store.x(i)));
+          mix(static_cast<float>(store.y(i)));
+          mix(store.mass(i));
+        }
+      };
+      mix_entities(state.pellets);
+      mix_entities(state.viruses);
+      mix_entities(state.foods);
+      return hash;
     }
 
+    /* summary of the profiled ticks (see profile::Profiler::report), empty unless `profiled` */
+    std::map<std::string, double> profile() const { return profiler_.report(); }
+
+    /* clears everything that the profiler has recorded */
+    void reset_profile() { profiler_.reset(); }
+
     void seed(unsigned s) {
       this->state.rng.seed(s);
-      std::srand(s);
     }
 
+    /**
+     * ticks the players on `num_threads` threads (the calling thread and a
+     * pool of num_threads - 1), or on the calling thread alone if 1. Players
+     * on a pool tick in phases, so a game plays out the same on any number of
+     * threads above one, but not as it does on one (see tick_players).
+     * Clones and copies tick on as many threads as their source.
+     */
+    void set_num_threads(int num_threads) {
+      if (num_threads < 1)
+        throw EngineException("Number of threads (" + std::to_string(num_threads) + ") must be positive");
+      if (num_threads == this->num_threads()) return;
+      pool_ = num_threads > 1 ? std::make_unique<WorkPool>(num_threads) : nullptr;
+    }
+
+    [[nodiscard]] int num_threads() const { return pool_ ? pool_->num_threads() : 1; }
+
+    /**
+     * spreads regeneration over ticks: every REGEN_INTERVAL_TICKS ticks, the
+     * pellets and viruses eaten since the last regeneration are owed to the
+     * arena, and each tick then adds at most `budget` of them (pellets
+     * first). With a budget of 0 (the default), they're all added at once.
+     */
+    void set_regen_budget(int budget) {
+      if (budget < 0)
+        throw EngineException("Regeneration budget (" + std::to_string(budget) + ") must not be negative");
+      regen_budget_ = budget;
+    }
+
+    [[nodiscard]] int regen_budget() const { return regen_budget_; }
+
+    /**
+     * places pellets and viruses along a low-discrepancy sequence (see
+     * R2Sequence) that starts from a random point at each reset, rather
+     * than independently at random, which covers the arena more evenly
+     * and more cheaply. Takes effect from the next reset.
+     */
+    void set_low_discrepancy_spawns(bool enabled) { low_discrepancy_spawns_ = enabled; }
+
+    [[nodiscard]] bool low_discrepancy_spawns() const { return low_discrepancy_spawns_; }
+
+    /**
+     * loads the state saved by an environment's save_env_state, either a
+     * binary snapshot (see agario/utils/snapshot.hpp) or a JSON export
+     */
     void load_env_state(const std::string &filename) {
+      if (snapshot::is_snapshot(filename)) {
+        _load_snapshot(filename);
+        return;
+      }
+
       using json = nlohmann::json;
-      using HungryBot = agario::bot::HungryBot<renderable>;
-      using HungryShyBot = agario::bot::HungryShyBot<renderable>;
-      using AggressiveBot = agario::bot::AggressiveBot<renderable>;
-      using AggressiveShyBot = agario::bot::AggressiveShyBot<renderable>;
       // Open the input file for reading
       std::ifstream in_file(filename);
       if (!in_file.is_open()) {
@@ -269,23 +360,7 @@ namespace agario {
         // if (state.players.find(pid) != state.players.end()) {
         //   throw EngineException("Duplicate Player ID: " + std::to_string(pid));
         // }
-        auto name = player_data["name"].get<std::string>();
-
-        agario::pid pid_added;
-        if(name == "HungryBot")
-          pid_added = this->template add_player<HungryBot>(name);
-        else if(name == "HungryShyBot")
-          pid_added = this->template add_player<HungryShyBot>(name);
-        else if(name == "AggressiveBot")
-          pid_added = this->template add_player<AggressiveBot>(name);
-        else if(name == "AggressiveShyBot")
-          pid_added = this->template add_player<AggressiveShyBot>(name);
-        else
-          pid_added = this->template add_player<Player>(name);
-
-
-        auto &player = this->player(pid_added);
-        player.cells.clear();
+        auto &player = _add_loaded_player(player_data["name"].get<std::string>());
         player.target.x = player_data["target_x"];
         player.target.y = player_data["target_y"];
         player.is_bot = player_data["is_bot"];
@@ -320,17 +395,19 @@ namespace agario {
         state.pellets.emplace_back(Location(static_cast<numWrapper<float, _distance>>(pellet_data["x"]),
                                             static_cast<numWrapper<float, _distance>>(pellet_data["y"])));
       }
+      state.pellet_index.rebuild(state.pellets);
 
       // Load viruses
       state.viruses.clear();
         for (const auto &virus_data : agarcl_data["viruses"]) {
-          Virus virus(Location(static_cast<numWrapper<float, _distance>>(virus_data["x"]),
-                   static_cast<numWrapper<float, _distance>>(virus_data["y"])));
-          virus.velocity.dx = static_cast<float>(virus_data["velocity_x"]);
-          virus.velocity.dy = static_cast<float>(virus_data["velocity_y"]);
-          virus.set_mass(static_cast<float>(virus_data["mass"]));
-          state.viruses.emplace_back(std::move(virus));
+          Location loc(static_cast<numWrapper<float, _distance>>(virus_data["x"]),
+                   static_cast<numWrapper<float, _distance>>(virus_data["y"]));
+          Velocity vel(static_cast<numWrapper<float, _distance>>(virus_data["velocity_x"]),
+                       static_cast<numWrapper<float, _distance>>(virus_data["velocity_y"]));
+          state.viruses.emplace_back(loc, vel);
+          state.viruses.set_mass(state.viruses.size() - 1, static_cast<float>(virus_data["mass"]));
         }
+        state.virus_index.rebuild(state.viruses);
 
         // Load foods
         state.foods.clear();
@@ -339,79 +416,281 @@ namespace agario {
           static_cast<numWrapper<float, _distance>>(food_data["y"]));
           Velocity vel(static_cast<numWrapper<float, _distance>>(food_data["velocity_x"]),
           static_cast<numWrapper<float, _distance>>(food_data["velocity_y"]));
-          Food food(loc, vel);
-          state.foods.emplace_back(std::move(food));
+          state.foods.emplace_back(loc, vel);
         }
+        index_foods();
         // Reset ticks
         state.ticks = 0;
         seed(agarcl_data["seed"]);
       }
 
+    /* writes the players and entities to a snapshot, after its header (see agario/utils/snapshot.hpp) */
+    void save_snapshot(snapshot::Writer &out) const {
+      out.write(static_cast<std::uint32_t>(state.players.size()));
+      std::vector<snapshot::CellRecord> cells;
+      for (const auto &[pid, player] : state.players) {
+        snapshot::PlayerRecord record = {};
+        record.pid = pid;
+        record.name_length = player->name().size();
+        record.target_x = player->target.x;
+        record.target_y = player->target.y;
+        record.is_bot = player->is_bot;
+        record.dead = player->dead();
+        record.split_cooldown = player->split_cooldown;
+        record.feed_cooldown = player->feed_cooldown;
+        record.anti_team_decay = player->anti_team_decay;
+        record.elapsed_ticks = player->elapsed_ticks;
+        record.last_decay_tick = player->last_decay_tick;
+        record.food_eaten = player->food_eaten;
+        record.highest_mass = player->highest_mass;
+        record.cells_eaten = player->cells_eaten;
+        record.viruses_eaten = player->viruses_eaten;
+        record.top_position = player->top_position;
+        record.num_cells = player->cells.size();
+        record.num_virus_eaten_ticks = player->virus_eaten_ticks.size();
+
+        cells.clear();
+        for (const auto &cell : player->cells)
+          cells.push_back({cell.id, cell.x, cell.y, cell.mass(), cell.velocity.dx, cell.velocity.dy});
+
+        out.write(record);
+        out.write_string(player->name());
+        out.write_array(cells.data(), cells.size());
+        out.write_array(player->virus_eaten_ticks.data(), player->virus_eaten_ticks.size());
+      }
+
+      _save_entities(out, state.pellets);
+      _save_entities(out, state.viruses);
+      _save_entities(out, state.foods);
+    }
+
+    /**
+     * Makes this engine's game an exact copy of `other`'s, from which both
+     * play out identically: its players (bots keep their type and state),
+     * entities, RNG state, tick count, game mode and number of threads
+     * (games on one thread and on several play out differently). The entity
+     * arrays are copied into the storage that this engine already holds, so
+     * repeatedly forking into the same engine only allocates for the players.
+     */
+    void copy_state_from(const Engine &other) {
+      if (&other == this) return;
+      if (arena_width() != other.arena_width() || arena_height() != other.arena_height()
+          || state.config.target_num_pellets != other.state.config.target_num_pellets
+          || state.config.target_num_viruses != other.state.config.target_num_viruses
+          || state.config.pellet_regen != other.state.config.pellet_regen)
+        throw EngineException("Can't copy the state of an engine with a different configuration");
+
+      state.copy_from(other.state);
+      mode_number = other.mode_number;
+      mode_ = other.mode_;
+      self_collision_iterations_ = other.self_collision_iterations_;
+      regen_budget_ = other.regen_budget_;
+      low_discrepancy_spawns_ = other.low_discrepancy_spawns_;
+      set_num_threads(other.num_threads());
+    }
+
+    /* a new engine with a copy of this engine's game (see copy_state_from) */
+    std::unique_ptr<Engine> clone() const {
+      auto engine = std::make_unique<Engine>(arena_width(), arena_height(),
+                                             state.config.target_num_pellets, state.config.target_num_viruses,
+                                             state.config.pellet_regen, mode_number);
+      engine->copy_state_from(*this);
+      return engine;
+    }
+
     Engine(const Engine &) = delete; // no copy constructor
     Engine &operator=(const Engine &) = delete; // no copy assignments
     Engine(Engine &&) = delete; // no move constructor
     Engine &operator=(Engine &&) = delete; // no move assignment
     int mode_number = 0;
   private:
-    int pellets_grid_size;  int virus_grid_size;
-    int pellets_grid_width; int virus_grid_width;
-    int pellets_grid_height; int virus_grid_height;
-    std::vector<std::vector<int>> pellets_grid;
-    std::vector<std::vector<int>> virus_grid;
-
-    bool mass_decay_ = true;
-    bool is_squared_pellets_ = false;
-    int agent_mass = 25;
-    bool regen_pellets = true;
-
-    void set_mode(int mode) {
-      switch (mode) {
-      case 0:
-        mass_decay_ = true;
-        is_squared_pellets_ = false;
-        regen_pellets = true;
-        agent_mass = 25;
-        break;
-      case 1:
-        mass_decay_ = false;
-        is_squared_pellets_ = true;
-        regen_pellets = false;
-        agent_mass = 25;
-        break;
-      case 2:
-        mass_decay_ = true;
-        is_squared_pellets_ = true;
-        regen_pellets = false;
-        agent_mass = 25;
-        break;
-      case 3:
-        mass_decay_ = false;
-        is_squared_pellets_ = false; // random
-        regen_pellets = true;
-        agent_mass = 25;
-        break;
-      case 4:
-        mass_decay_ = true;
-        is_squared_pellets_ = false;
-        regen_pellets = true;
-        agent_mass = 25;
-        break;
-      case 5:
-        set_mode(2);
-        agent_mass = 1000;
-        break;
-      case 6:
-        set_mode(4);
-        agent_mass = 1000;
-        break;
-      case 7:
-      case 8:
-      case 9:
-      case 10:
-        set_mode(4);
-        break;
-      default:
-        throw EngineException("Invalid mode number");
+    // marks pellets, foods and viruses that have been eaten during the current tick
+    std::vector<char> pellet_eaten_;
+    std::vector<char> food_eaten_;
+    std::vector<char> virus_hit_;
+    int num_foods_eaten_ = 0;
+
+    // number of ticks that cells must wait to recombine, at the current tick rate
+    agario::tick recombine_ticks_ = 0;
+
+    // every player's cells, flattened for the cell-cell broadphase
+    std::vector<std::pair<Player *, int>> cell_refs_;
+    agario::SweepAndPrune cell_broadphase_;
+    std::vector<std::pair<int, int>> cell_eats_;  // (eater, eaten) indices into cell_refs_
+    std::vector<char> cell_eaten_;
+
+    Cell &cell_at(int ref) { return cell_refs_[ref].first->cells[cell_refs_[ref].second]; }
+
+    /* adds a player of the (bot) type named `name`, without any cells, to be filled in from a saved state */
+    Player &_add_loaded_player(const std::string &name) {
+      using HungryBot = agario::bot::HungryBot<renderable>;
+      using HungryShyBot = agario::bot::HungryShyBot<renderable>;
+      using AggressiveBot = agario::bot::AggressiveBot<renderable>;
+      using AggressiveShyBot = agario::bot::AggressiveShyBot<renderable>;
+
+      agario::pid pid_added;
+      if(name == "HungryBot")
+        pid_added = this->template add_player<HungryBot>(name);
+      else if(name == "HungryShyBot")
+        pid_added = this->template add_player<HungryShyBot>(name);
+      else if(name == "AggressiveBot")
+        pid_added = this->template add_player<AggressiveBot>(name);
+      else if(name == "AggressiveShyBot")
+        pid_added = this->template add_player<AggressiveShyBot>(name);
+      else
+        pid_added = this->template add_player<Player>(name);
+
+      auto &player = this->player(pid_added);
+      player.cells.clear();
+      return player;
+    }
+
+    /* loads a binary snapshot, the same way as load_env_state loads a JSON export */
+    void _load_snapshot(const std::string &filename) {
+      snapshot::Reader in(filename);
+      set_mode_number(in.header().mode_number);
+
+      state.players.clear();
+      auto num_players = in.read<std::uint32_t>();
+      for (std::uint32_t p = 0; p < num_players; p++) {
+        auto record = in.read<snapshot::PlayerRecord>();
+        auto &player = _add_loaded_player(in.read_string(record.name_length));
+        player.target.x = record.target_x;
+        player.target.y = record.target_y;
+        player.is_bot = record.is_bot;
+        player.split_cooldown = record.split_cooldown;
+        player.feed_cooldown = record.feed_cooldown;
+        player.anti_team_decay = record.anti_team_decay;
+        player.elapsed_ticks = record.elapsed_ticks;
+        player.last_decay_tick = record.last_decay_tick;
+        player.food_eaten = record.food_eaten;
+        player.highest_mass = record.highest_mass;
+        player.cells_eaten = record.cells_eaten;
+        player.viruses_eaten = record.viruses_eaten;
+        player.top_position = record.top_position;
+
+        auto cells = in.read_array<snapshot::CellRecord>(record.num_cells);
+        player.cells.reserve(record.num_cells);
+        for (std::uint32_t c = 0; c < record.num_cells; c++) {
+          Velocity vel(agario::distance(cells[c].velocity_x), agario::distance(cells[c].velocity_y));
+          Cell cell(Location(cells[c].x, cells[c].y), std::move(vel), cells[c].mass);
+          cell.id = cells[c].id;
+          player.cells.push_back(std::move(cell));
+        }
+
+        auto ticks = in.read_array<std::int32_t>(record.num_virus_eaten_ticks);
+        player.virus_eaten_ticks.insert(player.virus_eaten_ticks.end(), ticks, ticks + record.num_virus_eaten_ticks);
+      }
+
+      _load_entities(in, state.pellets);
+      state.pellet_index.rebuild(state.pellets);
+      _load_entities(in, state.viruses);
+      state.virus_index.rebuild(state.viruses);
+      _load_entities(in, state.foods);
+      index_foods();
+
+      state.ticks = 0;
+      seed(in.header().seed);
+    }
+
+    /* writes the count and then the field arrays of the entities in `store` */
+    template<typename Store>
+    static void _save_entities(snapshot::Writer &out, const Store &store) {
+      using traits = typename Store::traits;
+      auto n = static_cast<std::uint32_t>(store.size());
+      out.write(n);
+
+      std::vector<float> field(n);
+      auto write_field = [&](auto &&get) {
+        for (std::uint32_t i = 0; i < n; i++) field[i] = get(i);
+        out.write_array(field.data(), n);
+      };
+      write_field([&](int i) { return store.x(i); });
+      write_field([&](int i) { return store.y(i); });
+      if constexpr (traits::moving) {
+        write_field([&](int i) { return store.velocity(i).dx; });
+        write_field([&](int i) { return store.velocity(i).dy; });
+      }
+      if constexpr (!traits::constant_mass) {
+        std::vector<agario::mass> masses(n);
+        for (std::uint32_t i = 0; i < n; i++) masses[i] = store.mass(i);
+        out.write_array(masses.data(), n);
+      }
+    }
+
+    /* replaces the entities in `store` with those written by _save_entities */
+    template<typename Store>
+    static void _load_entities(snapshot::Reader &in, Store &store) {
+      using traits = typename Store::traits;
+      auto n = in.read<std::uint32_t>();
+      const float *x = in.read_array<float>(n);
+      const float *y = in.read_array<float>(n);
+      const float *vx = nullptr, *vy = nullptr;
+      const agario::mass *mass = nullptr;
+      if constexpr (traits::moving) {
+        vx = in.read_array<float>(n);
+        vy = in.read_array<float>(n);
+      }
+      if constexpr (!traits::constant_mass)
+        mass = in.read_array<agario::mass>(n);
+      store.assign(n, x, y, vx, vy, mass);
+    }
+
+    using Profiler = std::conditional_t<profiled, profile::Profiler, profile::NoProfiler>;
+    Profiler profiler_;
+
+    // ticks players concurrently, if set_num_threads was given more than one thread
+    std::unique_ptr<WorkPool> pool_;
+    std::vector<Profiler> worker_profilers_; // what each of the pool's threads profiled during a tick
+
+    /* buffers for finding the touching cells of a player, kept between ticks */
+    struct SelfCollisions {
+      agario::SweepAndPrune broadphase;
+      std::vector<std::pair<int, int>> pairs;
+    };
+    SelfCollisions self_collisions_; // for check_player_self_collisions outside of ticks (see EngineInternals)
+    int self_collision_iterations_ = SELF_COLLISION_ITERATIONS;
+    int regen_budget_ = DEFAULT_REGEN_BUDGET;
+    bool low_discrepancy_spawns_ = false;
+
+    /* what start_player_tick found for a player, which hit_virus and finish_player_tick apply to the game */
+    struct PlayerTick {
+      std::vector<Cell> created_cells;
+      std::vector<std::pair<int, int>> viruses_reached; // (cell, virus) for the viruses each cell can eat
+      std::vector<std::pair<int, int>> pellets_reached; // (cell, pellet) for the pellets near each cell
+      agario::Rng rng;                                  // the player's generator for its actions
+      SelfCollisions self_collisions;
+      int create_limit = 0;
+      bool can_eat_virus = false;
+    };
+    std::vector<Player *> tick_players_; // the live players, in the order that they take turns
+    std::vector<PlayerTick> player_ticks_;
+
+    GameMode mode_;
+
+    /* takes on the rules of mode `mode_number` */
+    void set_mode(int mode_number) {
+      switch (mode_number) {
+        case 0: case 4: case 7: case 8: case 9: case 10:
+          mode_ = GameMode{true, true, false, 25};
+          break;
+        case 1:
+          mode_ = GameMode{false, false, true, 25};
+          break;
+        case 2:
+          mode_ = GameMode{true, false, true, 25};
+          break;
+        case 3:
+          mode_ = GameMode{false, true, false, 25};
+          break;
+        case 5:
+          mode_ = GameMode{true, false, true, 1000};
+          break;
+        case 6:
+          mode_ = GameMode{true, true, false, 1000};
+          break;
+        default:
+          throw EngineException("Invalid mode number");
       }
     }
 
@@ -419,8 +698,9 @@ namespace agario {
     {
       agario::distance pellet_radius = agario::radius_conversion(PELLET_MASS);
       for (int p = 0; p < n; p++) {
-        state.pellets.emplace_back(random_location(pellet_radius));
+        state.pellets.emplace_back(spawn_location(pellet_radius));
       }
+      state.pellet_index.extend(state.pellets);
     }
 
     void create_squared_pellets(int n) {
@@ -472,6 +752,8 @@ namespace agario {
           state.pellets.emplace_back(Location(left_x, left_y));
           }
       }
+
+      state.pellet_index.extend(state.pellets);
     }
 
 
@@ -481,63 +763,244 @@ namespace agario {
       agario::distance virus_radius = agario::radius_conversion(VIRUS_INITIAL_MASS);
       int mx_num_viruses = std::min(arena_height(), arena_width())/virus_radius;
         for (int v = 0; v < n; v++)
-          state.viruses.emplace_back(random_location(virus_radius));
+          state.viruses.emplace_back(spawn_location(virus_radius));
+      state.virus_index.extend(state.viruses);
+    }
+
+    /* adds the pellets and then viruses that are owed to the arena, up to the regeneration budget */
+    void regenerate() {
+      int budget = regen_budget_ > 0 ? regen_budget_ : std::numeric_limits<int>::max();
+      int pellets = std::min(state.pending_pellets, budget);
+      add_pellets(pellets);
+      state.pending_pellets -= pellets;
+
+      int viruses = std::min(state.pending_viruses, budget - pellets);
+      add_viruses(viruses);
+      state.pending_viruses -= viruses;
+    }
+
+    /* where to place a new pellet or virus of the given radius (see set_low_discrepancy_spawns) */
+    agario::Location spawn_location(agario::distance radius) {
+      if (!low_discrepancy_spawns_)
+        return random_location(radius);
+
+      auto [u, v] = state.spawn_sequence();
+      return Location(radius + u * (arena_width() - 2 * radius),
+                      radius + v * (arena_height() - 2 * radius));
+    }
+
+    /* the body of tick, following the rules of the game mode `Rules` */
+    template<typename Rules>
+    void _tick(const agario::time_delta &elapsed_seconds) {
+      recombine_ticks_ = static_cast<agario::tick>(std::ceil(RECOMBINE_TIMER_SEC / elapsed_seconds.count()));
+      index_added_entities();
+      std::vector<int> pellets_to_remove;
+      std::vector<int> viruses_to_remove;
+      tick_players<Rules>(elapsed_seconds, pellets_to_remove, viruses_to_remove);
+
+      // remove the pellets, foods and viruses that have been eaten
+      {
+        auto scope = profiler_.scope(profile::remove_entities);
+        remove_pellets(pellets_to_remove);
+        remove_eaten_foods();
+        remove_viruses(viruses_to_remove);
+      }
+
+      {
+        auto scope = profiler_.scope(profile::players_collision);
+        players_collision();
+      }
+
+      {
+        auto scope = profiler_.scope(profile::move_foods);
+        move_foods(elapsed_seconds);
+      }
+
+      if constexpr (Rules::regen_pellets) {
+        if(state.ticks % REGEN_INTERVAL_TICKS == 0){ //every 6 seconds
+          // owe the arena whatever has been eaten since it was last full
+          state.pending_pellets = std::max(0, static_cast<int>(state.config.target_num_pellets) - pellet_count());
+          state.pending_viruses = std::max(0, static_cast<int>(state.config.target_num_viruses) - virus_count());
+        }
+        if (state.pending_pellets > 0 || state.pending_viruses > 0) {
+          auto scope = profiler_.scope(profile::regen);
+          regenerate();
+        }
+      }
+      state.ticks++;
+
+      if constexpr (profiled) {
+        int num_cells = 0;
+        for (auto &pair : state.players)
+          num_cells += pair.second->cells.size();
+        profiler_.end_tick(state.players.size(), num_cells, state.pellets.size(),
+                           state.foods.size(), state.viruses.size());
+      }
+
     }
 
     /**
-     * "ticks" the given player, which involves moving the player's cells and checking
-     * for collisions between the player and all other entities in the arena
-     * Also performs any player actions (i.e. splitting or feeling) decrements
-     * the cooldown timers on the player actions
-     * @param player the player to tick
-     * @param elapsed_seconds the amount of (game) time since the last game tick
+     * ticks every live player, in order of pid (as `state.players` is). On a single
+     * thread, each player takes its whole turn before the next one starts:
+     * every tenth tick it chooses its action (drawing from the game's
+     * generator), then it moves, hits a virus, eats pellets and foods, and
+     * splits, feeds and recombines. With a pool of threads (see
+     * set_num_threads), the players instead tick in three phases, so that
+     * the first two, which do most of the work, can run concurrently:
+     *  1. every tenth tick, the players choose their actions from the state
+     *     at the start of the tick, each with a generator seeded from the
+     *     game's
+     *  2. each player moves, and finds the viruses and pellets that its cells
+     *     reach, in start_player_tick and find_reached_pellets
+     *  3. in turn, each player hits a virus and eats those pellets (unless an
+     *     earlier player got them first), then takes the rest of its turn
+     * A phased game plays out the same on any number of threads, but not the
+     * same as on a single thread, since the players no longer see each
+     * other's moves within a tick.
      */
-    void tick_player(Player &player, const agario::time_delta &elapsed_seconds, std::vector<int>&pellets_to_remove, std::vector<int>& viruses_to_remove) {
-      player.elapsed_ticks += 1;
+    template<typename Rules>
+    void tick_players(const agario::time_delta &elapsed_seconds,
+                      std::vector<int> &pellets_to_remove, std::vector<int> &viruses_to_remove) {
+      tick_players_.clear();
+      for (auto &pair : state.players)
+        if (!pair.second->dead())
+          tick_players_.push_back(pair.second.get());
+      int num_players = tick_players_.size();
+      if (player_ticks_.size() < tick_players_.size())
+        player_ticks_.resize(num_players);
+
+      if (!pool_) {
+        for (int i = 0; i < num_players; i++) {
+          Player &player = *tick_players_[i];
+          PlayerTick &tick = player_ticks_[i];
+          player.elapsed_ticks += 1;
+          if (ticks() % 10 == 0) {
+            auto scope = profiler_.scope(profile::bot_actions);
+            player.take_action(state, state.rng);
+          }
+          start_player_tick(player, tick, elapsed_seconds, profiler_);
+          hit_virus(player, tick, viruses_to_remove);
+          {
+            auto scope = profiler_.scope(profile::pellet_collisions);
+            find_reached_pellets(player.cells, tick.pellets_reached, profiler_);
+          }
+          finish_player_tick<Rules>(player, tick, pellets_to_remove);
+        }
+        return;
+      }
 
-      if (ticks() % 10 == 0)
-        player.take_action(state);
+      for (Player *player : tick_players_)
+        player->elapsed_ticks += 1;
 
-      move_player(player, elapsed_seconds);
+      if (ticks() % 10 == 0) {
+        for (int i = 0; i < num_players; i++)
+          player_ticks_[i].rng.seed(state.rng());
+        for_each_ticking_player([this](int i, Profiler &profiler) {
+          auto scope = profiler.scope(profile::bot_actions);
+          tick_players_[i]->take_action(state, player_ticks_[i].rng);
+        });
+      }
 
-      int prev_player_cells = player.cells.size();
+      for_each_ticking_player([this, &elapsed_seconds](int i, Profiler &profiler) {
+        Player &player = *tick_players_[i];
+        start_player_tick(player, player_ticks_[i], elapsed_seconds, profiler);
+        auto scope = profiler.scope(profile::pellet_collisions);
+        find_reached_pellets(player.cells, player_ticks_[i].pellets_reached, profiler);
+      });
 
-      std::vector<Cell> created_cells; // list of new cells that will be created
-      int create_limit = PLAYER_CELL_LIMIT - prev_player_cells;
+      for (int i = 0; i < num_players; i++) {
+        hit_virus(*tick_players_[i], player_ticks_[i], viruses_to_remove);
+        finish_player_tick<Rules>(*tick_players_[i], player_ticks_[i], pellets_to_remove);
+      }
+    }
 
-      bool can_eat_virus = ((player.cells.size() >= NUM_CELLS_TO_SPLIT));
+    /**
+     * calls f(i, profiler) for each of the `tick_players_`, on the pool's
+     * threads if there is a pool, with a profiler for the calling thread
+     */
+    template<typename F>
+    void for_each_ticking_player(F &&f) {
+      int num_players = tick_players_.size();
+      if (!pool_ || num_players < 2) {
+        for (int i = 0; i < num_players; i++)
+          f(i, profiler_);
+        return;
+      }
 
+      worker_profilers_.resize(pool_->num_threads());
+      pool_->run(num_players, [this, &f](int i, int worker) { f(i, worker_profilers_[worker]); });
+      for (auto &worker_profiler : worker_profilers_) {
+        profiler_.merge(worker_profiler);
+        worker_profiler.reset();
+      }
+    }
 
-      if(optimized_check_virus_collisions(player.cells, created_cells, create_limit, can_eat_virus, viruses_to_remove)){
-        player.virus_eaten_ticks.emplace_back(player.elapsed_ticks);
-        player.viruses_eaten++;
+    /**
+     * moves the given player's cells, and finds the viruses that they reach.
+     * Reads the rest of the game but only writes to `player`, `tick` and
+     * `profiler`, so that players can be ticked concurrently.
+     * @param player the player to tick
+     * @param tick where to leave the player's tick for hit_virus and finish_player_tick
+     * @param elapsed_seconds the amount of (game) time since the last game tick
+     */
+    void start_player_tick(Player &player, PlayerTick &tick, const agario::time_delta &elapsed_seconds,
+                           Profiler &profiler) {
+      move_player(player, elapsed_seconds, profiler, tick.self_collisions);
+
+      tick.created_cells.clear();
+      tick.create_limit = PLAYER_CELL_LIMIT - player.cells.size();
+      tick.can_eat_virus = player.cells.size() >= NUM_CELLS_TO_SPLIT;
+
+      auto scope = profiler.scope(profile::virus_collisions);
+      find_reached_viruses(player.cells, tick.viruses_reached, profiler);
+    }
+
+    /**
+     * completes the tick of the given player: eats the pellets that were
+     * found near its cells and the foods that its cells reach, performs its
+     * actions (i.e. splitting or feeding), decrements the cooldown timers on
+     * them, and recombines its cells
+     * @param player the player to tick
+     * @param tick what start_player_tick and find_reached_pellets found for the player
+     */
+    template<typename Rules>
+    void finish_player_tick(Player &player, PlayerTick &tick, std::vector<int> &pellets_to_remove) {
+      {
+        auto scope = profiler_.scope(profile::pellet_collisions);
+        int before = pellets_to_remove.size();
+        eat_reached_pellets(player.cells, tick.pellets_reached, pellets_to_remove);
+        player.food_eaten  += pellets_to_remove.size() - before;
       }
-      int before = pellets_to_remove.size();
-      get_pellets_to_remove_and_increment_cells(player.cells, pellets_to_remove);
-      player.food_eaten  += pellets_to_remove.size() - before;
       player.highest_mass = std::max(player.highest_mass, player.mass());
 
+      auto &created_cells = tick.created_cells;
+      int create_limit = tick.create_limit;
       for (Cell &cell : player.cells) {
-        can_eat_virus &= cell.mass() >= MIN_CELL_SPLIT_MASS;
-        may_be_auto_split(cell, created_cells, create_limit, player.cells.size(), player.target);
-        // player.food_eaten +=eat_pellets(cell);
+        {
+          auto scope = profiler_.scope(profile::split_and_merge);
+          may_be_auto_split(cell, created_cells, create_limit, player.cells.size(), player.target);
+        }
+        auto scope = profiler_.scope(profile::food_collisions);
         player.food_eaten +=eat_food(cell);
       }
+
+      auto scope = profiler_.scope(profile::split_and_merge);
       create_limit -= created_cells.size();
       maybe_emit_food(player);
       maybe_split(player, created_cells, create_limit);
 
       // add any cells that were created
       player.add_cells(created_cells, !state.config.multi_channel_observation);
-      // created_cells.erase(created_cells.begin(), created_cells.end());
 
       recombine_cells(player);
 
       // some actions do not need to happen every tick
       // these will be executed once per second
-      if (mass_decay_ == true && player.elapsed_ticks % 60 == 0) {
-        maybe_activate_anti_team(player);
-        mass_decay(player);
+      if constexpr (Rules::mass_decay) {
+        if (player.elapsed_ticks % 60 == 0) {
+          maybe_activate_anti_team(player);
+          mass_decay(player);
+        }
       }
     }
 
@@ -606,84 +1069,155 @@ namespace agario {
      * @param player the player to move
      * @param elapsed_seconds time since the last game tick
      */
-    void move_player(Player &player, const agario::time_delta &elapsed_seconds) {
+    void move_player(Player &player, const agario::time_delta &elapsed_seconds, Profiler &profiler,
+                     SelfCollisions &self_collisions) {
 
       //check whether the player target is out of arena or not
 
-      auto dt = elapsed_seconds.count();
-      agario::mass smallest_mass_cell = std::numeric_limits<agario::mass>::max();
-
-      for (auto &cell : player.cells) {
-        cell.velocity.dx = 3 * (player.target.x - cell.x);
-        cell.velocity.dy = 3 * (player.target.y - cell.y);
-        smallest_mass_cell = std::min(smallest_mass_cell, cell.mass());
-        // clip speed
-        auto speed_limit = max_speed(cell.mass());
-        cell.velocity.clamp_speed(0, speed_limit);
-        cell.move(dt);
-        cell.splitting_velocity.decelerate(SPLIT_DECELERATION, dt);
-        check_boundary_collisions(cell);
-      }
-      player.set_min_mass_cell(smallest_mass_cell);
+      {
+        auto scope = profiler.scope(profile::move);
+        auto dt = elapsed_seconds.count();
+        agario::mass smallest_mass_cell = std::numeric_limits<agario::mass>::max();
+
+        for (auto &cell : player.cells) {
+          cell.velocity.dx = 3 * (player.target.x - cell.x);
+          cell.velocity.dy = 3 * (player.target.y - cell.y);
+          smallest_mass_cell = std::min(smallest_mass_cell, cell.mass());
+          // clip speed
+          auto speed_limit = max_speed(cell.mass());
+          cell.velocity.clamp_speed(0, speed_limit);
+          cell.move(dt);
+          cell.splitting_velocity.decelerate(SPLIT_DECELERATION, dt);
+          check_boundary_collisions(cell);
+        }
+        player.set_min_mass_cell(smallest_mass_cell);
+      }
+
       // make sure not to move two of players own cells into one another
-      check_player_self_collisions(player, elapsed_seconds);
+      auto scope = profiler.scope(profile::self_collisions);
+      check_player_self_collisions(player, elapsed_seconds, self_collisions);
     }
 
+    /**
+     * moves the foods that are still moving (`state.moving_foods`), keeping
+     * the food index up to date, and feeds any virus that they hit (see
+     * maybe_hit_virus). Foods at rest are not visited at all, and foods that
+     * come to rest are dropped from `moving_foods`.
+     */
     void move_foods(const agario::time_delta &elapsed_seconds) {
       auto dt = elapsed_seconds.count();
-
-      for (auto food_it = state.foods.begin() ; food_it != state.foods.end(); ) {
-        if (food_it->velocity.magnitude() == 0) {
-          food_it++;
-          continue;
-        }
-
-        Velocity food_vel = food_it->velocity;
-        food_it->decelerate(FOOD_DECEL, dt);
-        food_it->move(dt);
-
-        check_boundary_collisions(*food_it);
-
-        bool hit_virus = maybe_hit_virus(*food_it, food_vel, elapsed_seconds);
+      index_added_entities();
+      auto &moving = state.moving_foods;
+      if (moving.empty()) return;
+
+      virus_reach_ = 0;
+      for (int v = 0; v < static_cast<int>(state.viruses.size()); v++)
+        virus_reach_ = std::max(virus_reach_, state.viruses.radius(v));
+
+      // Foods are visited in increasing order, as if every food were. When a food
+      // hits a virus, the last food takes its place, and is moved next if it's moving.
+      auto &foods = state.foods;
+      int kept = 0;
+      int end = moving.size();
+      for (int k = 0; k < end; ) {
+        int i = moving[k];
+        Velocity food_vel = foods.velocity(i);
+        Velocity vel = food_vel;
+        vel.decelerate(FOOD_DECEL, dt);
+        foods.set_velocity(i, vel);
+        foods.set_location(i, foods.x(i) + vel.dx * dt, foods.y(i) + vel.dy * dt);
+
+        check_boundary_collisions(foods, i);
+
+        bool hit_virus = maybe_hit_virus(foods.location(i), foods.radius(i), food_vel, elapsed_seconds);
 
         if(hit_virus) {
-            if(state.foods.size() > 1)
-              std::swap(*food_it, state.foods.back());
-            state.foods.pop_back();
-          } else
-              ++food_it;
+          int last = foods.size() - 1;
+          state.food_index.erase(i);
+          foods.swap_remove(i);
+          if (i != last && moving[end - 1] == last) {
+            end--; // the last food, now at i, is yet to move
+            continue;
+          }
+        } else {
+          state.food_index.move(i, foods.x(i), foods.y(i));
+          if (vel.magnitude() != 0)
+            moving[kept++] = i;
+        }
+        k++;
       }
+      moving.resize(kept);
     }
 
+    // the radius of the largest virus, which bounds how far maybe_hit_virus searches
+    agario::distance virus_reach_ = 0;
+
     /*
-    * Check for collisions between the foods and viruses in the game
+    * Check for collisions between the food and the viruses in the buckets of the
+    * virus index around it. If it hits several, the first of them is fed.
     */
-    bool maybe_hit_virus(const Food &food, const Velocity &food_vel, const agario::time_delta &elapsed_seconds) {
+    bool maybe_hit_virus(const Location &food_loc, agario::distance food_radius,
+                         const Velocity &food_vel, const agario::time_delta &elapsed_seconds) {
       auto dt = elapsed_seconds.count();
-      for (auto &virus : state.viruses) {
-
-        if (food.collides_with(virus)) {
-            if(virus.get_num_food_hits() >= NUMBER_OF_FOOD_HITS) {
-              // Return the virus to its original mass.
-              virus.set_num_food_hits(0);
-              virus.set_mass(VIRUS_INITIAL_MASS);
-
-              // For the new virus take the food direction and location with VIRUSS NORMAL MASS.
-              Velocity vel = food_vel;
-              Virus new_virus(Location(virus.x,virus.y), vel);
-              new_virus.move(dt*10);
-              check_boundary_collisions(new_virus);
-              new_virus.set_mass(VIRUS_INITIAL_MASS);
-              state.viruses.emplace_back(std::move(new_virus));
-            } else {
-
-              virus.set_num_food_hits(virus.get_num_food_hits() + 1);
-              virus.set_mass(virus.mass() + FOOD_MASS);
-            }
-            return true;
-        }
+      auto &viruses = state.viruses;
+      int v = first_colliding(state.virus_index, viruses, food_loc, food_radius,
+                              std::max(food_radius, virus_reach_));
+      if (v < 0) return false;
+
+      if(viruses.food_hits(v) >= NUMBER_OF_FOOD_HITS) {
+        // Return the virus to its original mass.
+        viruses.set_food_hits(v, 0);
+        viruses.set_mass(v, VIRUS_INITIAL_MASS);
+
+        // For the new virus take the food direction and location with VIRUSS NORMAL MASS.
+        Location loc(viruses.x(v) + food_vel.dx * dt * 10, viruses.y(v) + food_vel.dy * dt * 10);
+        viruses.emplace_back(loc, food_vel);
+        int added = viruses.size() - 1;
+        check_boundary_collisions(viruses, added);
+        state.virus_index.insert(added, viruses.x(added), viruses.y(added));
+      } else {
+
+        viruses.set_food_hits(v, viruses.food_hits(v) + 1);
+        viruses.set_mass(v, viruses.mass(v) + FOOD_MASS);
+        virus_reach_ = std::max(virus_reach_, viruses.radius(v));
       }
-      return false;
+      return true;
+    }
+
+    /**
+     * the lowest index of the entities in `index` that a ball at `loc` with
+     * radius `radius` collides with, or -1 if there are none. Searches the
+     * buckets within `reach` of `loc`, which must be at least the larger of
+     * `radius` and the radii of the entities.
+     */
+    template<typename Entities>
+    static int first_colliding(const agario::SpatialHash &index, const Entities &entities,
+                               const Location &loc, agario::distance radius, agario::distance reach) {
+      int first = -1;
+      index.for_each_near(loc.x, loc.y, reach, [&](int i) {
+        if ((first < 0 || i < first) && collides(loc, radius, entities, i))
+          first = i;
+      });
+      return first;
+    }
+
+    /* indexes any foods and viruses that were added to the state directly, e.g. by benchmarks */
+    void index_added_entities() {
+      int first = state.food_index.size();
+      state.food_index.extend(state.foods);
+      for (int i = first; i < static_cast<int>(state.foods.size()); i++)
+        if (state.foods.velocity(i).magnitude() != 0)
+          state.moving_foods.push_back(i);
+      state.virus_index.extend(state.viruses);
+    }
+
+    /* indexes all of the foods from scratch, e.g. after they were loaded */
+    void index_foods() {
+      state.food_index.rebuild(state.foods);
+      state.moving_foods.clear();
+      for (int i = 0; i < static_cast<int>(state.foods.size()); i++)
+        if (state.foods.velocity(i).magnitude() != 0)
+          state.moving_foods.push_back(i);
     }
 
 
@@ -697,6 +1231,31 @@ namespace agario {
             ball.y = std::max(static_cast<agario::distance>(0.0), clamp<agario::distance>(ball.y, ball.radius(), arena_height()-ball.radius()));
         }
 
+    /* constrains the location of entity `i` of `entities` to be inside the arena */
+    template<typename Entities>
+    void check_boundary_collisions(Entities &entities, int i) {
+      auto radius = entities.radius(i);
+      entities.set_location(i,
+        std::max(static_cast<agario::distance>(0.0), clamp<agario::distance>(entities.x(i), radius, arena_width() - radius)),
+        std::max(static_cast<agario::distance>(0.0), clamp<agario::distance>(entities.y(i), radius, arena_height() - radius)));
+    }
+
+    /* whether a ball at `loc` with radius `radius` collides with entity `i` of `entities` (as in Ball::collides_with) */
+    template<typename Entities>
+    static bool collides(const Location &loc, agario::distance radius, const Entities &entities, int i) {
+      auto sqr_rads = pow(std::max(radius, entities.radius(i)), 2);
+      auto dx = loc.x - entities.x(i);
+      auto dy = loc.y - entities.y(i);
+      return sqr_rads >= dx * dx + dy * dy;
+    }
+
+    /* whether `cell` can eat entity `i` of `entities`, and is close enough to do so */
+    template<typename Entities>
+    static bool can_eat(const Cell &cell, const Entities &entities, int i) {
+      return cell.mass() > entities.mass(i) * CELL_EAT_MARGIN &&
+             collides(cell.location(), cell.radius(), entities, i);
+    }
+
 
     void avoid_static_overlap(Cell &cell_a, Cell& cell_b)
     {
@@ -752,46 +1311,68 @@ namespace agario {
               return static_cast<int>(x / border * precision);
     }
 
+  public:
+    /* the most passes that check_player_self_collisions makes over a player's cells each tick */
+    [[nodiscard]] int self_collision_iterations() const { return self_collision_iterations_; }
+
+    void set_self_collision_iterations(int iterations) {
+      if (iterations < 1)
+        throw EngineException("Self-collision iterations (" + std::to_string(iterations) + ") must be positive");
+      self_collision_iterations_ = iterations;
+    }
+
+  private:
     /**
      * Moves all of `player`'s cells apart slightly such that
      * cells which aren't eligible for recombining don't overlap
      * with other cells of the same player.
      */
-    // NEED TO OPTIMIZE THIS FUNCTION: BIG BIG BIG O(n^2) for each player, so it is O(M*N^2): N is the number of cells and M is the number of Players
-    // What if we can make it O(M*N*log(N)), or Much better O(M*N)? How?
-    // One option left to try is to use the quadtree data structure to store the cells of each player, and then check the cells that are close to each other: Should try after the cleanup.
     void check_player_self_collisions(Player &player, const agario::time_delta &elapsed_seconds) {
-    bool overlap = false;
-    for(int iter = 0 ; iter < 5 ;iter++){
-      overlap = false;
-      for (int idx_a = 0; idx_a < player.cells.size(); idx_a++) {
-        for (int idx_b = idx_a + 1; idx_b < player.cells.size(); idx_b++) {
-          Cell &cell_a = player.cells[idx_a];
-          Cell &cell_b = player.cells[idx_b];
-          if (cell_a.touches(cell_b)) {
+      check_player_self_collisions(player, elapsed_seconds, self_collisions_);
+    }
+
+    /**
+     * Each pass pushes apart the pairs of cells that touch, in the order of
+     * their indices, and passes continue until none touch or the iteration
+     * budget runs out, after which any that still touch are separated
+     * outright. Only pairs whose x-extents overlap at the start of a pass
+     * are checked, so pairs that only come to touch during a pass are left
+     * to the next one.
+     */
+    void check_player_self_collisions(Player &player, const agario::time_delta &elapsed_seconds,
+                                      SelfCollisions &scratch) {
+      auto &cells = player.cells;
+      if (cells.size() < 2) return;
+
+      bool overlap = false;
+      for (int iter = 0; iter < self_collision_iterations_; iter++) {
+        overlap = false;
+        for (auto [a, b] : overlapping_cells(cells, scratch)) {
+          if (cells[a].touches(cells[b])) {
             overlap = true;
-            prevent_overlap(cell_a, cell_b, elapsed_seconds, player.target);
+            prevent_overlap(cells[a], cells[b], elapsed_seconds, player.target);
           }
         }
+        if (!overlap)
+          break;
       }
-      if(!overlap)
-        break;
-    }
-
-    if(overlap)
-    {
-      for (int idx_a = 0; idx_a < player.cells.size(); idx_a++) {
-        for (int idx_b = idx_a + 1; idx_b < player.cells.size(); idx_b++) {
 
-          Cell &cell_a = player.cells[idx_a];
-          Cell &cell_b = player.cells[idx_b];
-          if (cell_a.touches(cell_b))
-            avoid_static_overlap(cell_a, cell_b);
-        }
+      if (overlap) {
+        for (auto [a, b] : overlapping_cells(cells, scratch))
+          if (cells[a].touches(cells[b]))
+            avoid_static_overlap(cells[a], cells[b]);
       }
     }
 
-  }
+    /* the pairs (a, b) of `cells`, a < b, whose x-extents overlap, in order */
+    const std::vector<std::pair<int, int>> &overlapping_cells(const std::vector<Cell> &cells, SelfCollisions &scratch) {
+      scratch.broadphase.clear();
+      for (auto &cell : cells)
+        scratch.broadphase.add(cell.x, cell.radius());
+
+      scratch.broadphase.overlaps_in_order(scratch.pairs);
+      return scratch.pairs;
+    }
 
     /**
      * Moves `cell_a` and `cell_b` apart slightly
@@ -938,92 +1519,113 @@ namespace agario {
     }
 
     /**
-     * checks for collisions between the given cell and
-     * all of the pellets in the game, removing those pellets
-     * from the game which the cell eats
-     * @param cell the cell which is doing the eating
+     * finds the pellets near each of the given cells using the persistent
+     * pellet index, as (cell, pellet) pairs in `reached`, which
+     * eat_reached_pellets then checks for collisions
      */
-    int eat_pellets(Cell &cell) {
-      auto prev_size = pellet_count();
-
-      state.pellets.erase(
-        std::remove_if(state.pellets.begin(), state.pellets.end(),
-                       [&](const Pellet &pellet) {
-                         return cell.can_eat(pellet) && cell.collides_with(pellet);
-                       }),
-        state.pellets.end());
-
-      auto num_eaten = prev_size - pellet_count();
-      cell.increment_mass(num_eaten * PELLET_MASS);
-
-      return num_eaten;
+    void find_reached_pellets(const std::vector<Cell> &cells, std::vector<std::pair<int, int>> &reached,
+                              Profiler &profiler) const {
+      reached.clear();
+      for (int c = 0; c < static_cast<int>(cells.size()); c++) {
+        auto &cell = cells[c];
+        state.pellet_index.for_each_near(cell.x, cell.y, cell.radius(), [&](int pellet_idx) {
+          profiler.count(profile::pellet_candidates);
+          reached.emplace_back(c, pellet_idx);
+        });
+      }
     }
 
-    void initialize_pellet_grid() {
-      pellets_grid_size = 510;
-      pellets_grid_width = (state.config.arena_width + pellets_grid_size - 1) / pellets_grid_size;
-      pellets_grid_height = (state.config.arena_height + pellets_grid_size - 1) / pellets_grid_size;
-      pellets_grid.resize(pellets_grid_width * pellets_grid_height);
-
-      for (int i = 0; i < state.pellets.size(); ++i) {
-      const Pellet &pellet = state.pellets[i];
-      int grid_x = static_cast<int>(pellet.x) / pellets_grid_size;
-      int grid_y = static_cast<int>(pellet.y) / pellets_grid_size;
-      pellets_grid[grid_y * pellets_grid_width + grid_x].push_back(i);
-      }
-    }
-
-    void get_pellets_to_remove_and_increment_cells(std::vector<Cell>& cells,
-                                                   std::vector<int>& pellets_to_remove
-                                                              ) {
-
-      for (auto &cell : cells) {
-      int grid_x = static_cast<int>(cell.x) / pellets_grid_size;
-      int grid_y = static_cast<int>(cell.y) / pellets_grid_size;
-
-        for (int dx = -1; dx <= 1; ++dx) {
-          for (int dy = -1; dy <= 1; ++dy) {
-          int nx = grid_x + dx;
-          int ny = grid_y + dy;
-            if (nx >= 0 && nx < pellets_grid_width && ny >= 0 && ny < pellets_grid_height && ny * pellets_grid_width + nx < pellets_grid.size()) {
-              for (int pellet_idx : pellets_grid[ny * pellets_grid_width + nx]) {
-              Pellet &pellet = state.pellets[pellet_idx];
-                if (cell.can_eat(pellet) && cell.collides_with(pellet)) {
-                  pellets_to_remove.push_back(pellet_idx);
-                  cell.increment_mass(PELLET_MASS);
-                }
-              }
-            }
-          }
+    /**
+     * checks for collisions between the given cells and the pellets that
+     * find_reached_pellets found near them. Eaten pellets are appended to
+     * `pellets_to_remove` (at most once each, across all players) and their
+     * mass is credited to the cell that ate them. The pellets themselves are
+     * only removed from the game by `remove_pellets`, at the end of the tick.
+     */
+    void eat_reached_pellets(std::vector<Cell> &cells, const std::vector<std::pair<int, int>> &reached,
+                             std::vector<int> &pellets_to_remove) {
+      if (pellet_eaten_.size() < state.pellets.size())
+        pellet_eaten_.resize(state.pellets.size(), false);
+
+      for (auto [c, pellet_idx] : reached) {
+        if (pellet_eaten_[pellet_idx]) continue;
+        if (can_eat(cells[c], state.pellets, pellet_idx)) {
+          pellet_eaten_[pellet_idx] = true;
+          pellets_to_remove.push_back(pellet_idx);
+          cells[c].increment_mass(PELLET_MASS);
         }
       }
     }
 
-    void remove_pellets(const std::vector<int>& pellets_to_remove) {
+    /**
+     * removes the given pellets from the game, updating the pellet index in place.
+     * Removal goes from the highest index down so that swapping the last pellet
+     * into a removed slot never moves a pellet that is yet to be removed.
+     */
+    void remove_pellets(std::vector<int>& pellets_to_remove) {
+      std::sort(pellets_to_remove.begin(), pellets_to_remove.end(), std::greater<int>());
       for (int idx : pellets_to_remove) {
-        if (idx < state.pellets.size() - 1 && state.pellets.size() > 1)
-          std::swap(state.pellets[idx], state.pellets.back());
-        if (state.pellets.size() >= 1)
-          state.pellets.pop_back();
+        pellet_eaten_[idx] = false;
+        state.pellet_index.erase(idx);
+        state.pellets.swap_remove(idx);
       }
     }
 
+    /**
+     * checks for collisions between the given cell and the foods near it in
+     * the food index, marking those that the cell eats (a cell can only eat
+     * foods smaller than itself, so its radius bounds the search). Foods that
+     * are already marked have been eaten this tick and are skipped. The foods
+     * themselves are only removed from the game by `remove_eaten_foods`, at
+     * the end of the tick.
+     * @return the number of foods that the cell ate
+     */
     int eat_food(Cell &cell) {
       if (cell.mass() < FOOD_MASS) return 0;
-      auto prev_size = food_count();
-
-      state.foods.erase(
-        std::remove_if(state.foods.begin(), state.foods.end(),
-                       [&](const Food &pellet) {
-                         return cell.can_eat(pellet) && cell.collides_with(pellet);
-                       }),
-        state.foods.end());
-      auto num_eaten = prev_size - food_count();
+
+      if (food_eaten_.size() < state.foods.size())
+        food_eaten_.resize(state.foods.size(), false);
+
+      int num_eaten = 0;
+      state.food_index.for_each_near(cell.x, cell.y, cell.radius(), [&](int food_idx) {
+        profiler_.count(profile::food_candidates);
+        if (food_eaten_[food_idx] || !can_eat(cell, state.foods, food_idx)) return;
+        food_eaten_[food_idx] = true;
+        num_eaten++;
+      });
+      num_foods_eaten_ += num_eaten;
       cell.increment_mass(num_eaten * FOOD_MASS);
 
       return num_eaten;
     }
 
+    /* removes the foods that were eaten this tick, keeping the rest in order, in a single pass */
+    void remove_eaten_foods() {
+      if (num_foods_eaten_ == 0) return;
+      if (food_eaten_.size() < state.foods.size())
+        food_eaten_.resize(state.foods.size(), false);
+
+      // renumber the moving foods that are left as the foods are compacted
+      auto &moving = state.moving_foods;
+      int kept = 0, moving_kept = 0;
+      int num_foods = state.foods.size();
+      int num_moving = moving.size();
+      for (int k = 0, i = 0; i < num_foods; i++) {
+        bool is_moving = k < num_moving && moving[k] == i;
+        k += is_moving;
+        if (food_eaten_[i]) continue;
+        if (is_moving) moving[moving_kept++] = kept;
+        kept++;
+      }
+      moving.resize(moving_kept);
+
+      auto eaten = [this](int i) { return food_eaten_[i] != 0; };
+      state.food_index.remove_if(eaten);
+      state.foods.remove_if(eaten);
+      std::fill(food_eaten_.begin(), food_eaten_.end(), false);
+      num_foods_eaten_ = 0;
+    }
+
     void emit_foods(Player &player) {
 
       // emit one pellet from each sufficiently large cell
@@ -1036,10 +1638,12 @@ namespace agario {
         Location loc = cell.location() + dir * cell.radius();
 
         Velocity vel(dir * FOOD_SPEED);
-        Food food(loc, vel);
 
-        state.foods.emplace_back(std::move(food));
-        cell.increment_mass(-food.mass());
+        state.foods.emplace_back(loc, vel);
+        state.food_index.insert(state.foods.size() - 1, loc.x, loc.y);
+        if (vel.magnitude() != 0)
+          state.moving_foods.push_back(state.foods.size() - 1);
+        cell.increment_mass(-state.foods.mass(state.foods.size() - 1));
       }
     }
 
@@ -1085,8 +1689,8 @@ namespace agario {
       Cell new_cell(loc, vel, split_mass);
       new_cell.splitting_velocity = vel;
 
-      cell.reset_recombine_timer();
-      new_cell.reset_recombine_timer();
+      reset_recombine_timer(cell);
+      reset_recombine_timer(new_cell);
 
       created_cells.emplace_back(std::move(new_cell));
       return true;
@@ -1106,67 +1710,16 @@ namespace agario {
       }
     }
 
-    /**
-     * Checks all pairs of players for collisions that result
-     * in one cell eating another. Updates the corresponding lists
-     * of cells in each player to reflect any collisions.
-     */
-    void check_player_collisions() {
-      for (auto p1_it = state.players.begin(); p1_it != state.players.end(); ++p1_it)
-        for (auto p2_it = std::next(p1_it); p2_it != state.players.end(); ++p2_it)
-          check_players_collisions(*p1_it->second, *p2_it->second);
-    }
-
-    /**
-     * Checks cell-cell collisions between players `p1` and `p2`
-     * and does consumptions/removal of cells that collide
-     * @param p1 The first players
-     * @param p2 The second player
-     */
-    void check_players_collisions(Player &p1, Player &p2) {
-      for (auto &cell : p2.cells)
-        p2.cells_eaten += eat_others(p1, cell);
-      for (auto &cell : p1.cells)
-        p1.cells_eaten +=eat_others(p2, cell);
-    }
-
-    /**
-     * Checks if `cell` collides with and can eat any of `player`'s
-     * cells. Updates the mas of `cell` and removes cells from
-     * `player` if any are eaten.
-     * todo: update this so that removals are O(1) making this
-     * section O(n) rather tha O(n^2)
-     */
-    int eat_others(Player &player, Cell &cell) {
-
-      agario::mass original_mass = player.mass();
-      int          original_size = player.cells.size();
-      // remove all the cells that we eat
-      player.cells.erase(
-        std::remove_if(player.cells.begin(), player.cells.end(),
-                       [&](const Cell &other_cell) {
-                         return cell.collides_with(other_cell) && cell.can_eat(other_cell);
-                       }),
-        player.cells.end());
-
-      agario::mass gained_mass = original_mass - player.mass();
-      cell.increment_mass(gained_mass);
-
-      int eaten_cells = original_size - player.cells.size();
-      return eaten_cells;
-
-    }
-
     void recombine_cells(Player &player) {
 
       for (auto it = player.cells.begin(); it != player.cells.end(); ++it) {
-        if (!it->can_recombine()) continue;
+        if (!it->can_recombine(state.ticks)) continue;
 
         Cell &cell = *it;
 
         for (auto it2 = std::next(it); it2 != player.cells.end();) {
           Cell &other = *it2;
-          if (other.can_recombine() && cell.touches(other)) {
+          if (other.can_recombine(state.ticks) && cell.touches(other)) {
             cell.increment_mass(other.mass());
             // swap the cell to the end and pop it off
             std::swap(*it2, player.cells.back());
@@ -1178,89 +1731,75 @@ namespace agario {
       }
     }
 
-    bool check_virus_collisions(Cell &cell, std::vector<Cell> &created_cells, int create_limit, bool can_eat_virus) {
-      for (auto it = state.viruses.begin(); it != state.viruses.end();) {
-        Virus &virus = *it;
-
-        if (cell.can_eat(virus) && cell.collides_with(virus)) {
-          /*
-          We have two options:
-                  1: if I am within the time of being splitted (Not yet recombined) and I am trying to eat another virus, good. Eat it!
-                  Note that You can consume viruses if you are split into 16 cells. One of them has to be at least 130 in mass
-                  (or 10% larger than the virus) to consume the viruses. You gain 100 mass from each virus you eat.
-                  2: If I am fully shaped and I am trying to eat a virus, then I will be splitted into multiple cells.
-
-          */
-          if(can_eat_virus)
-            cell.increment_mass(virus.mass());
-          else
-            disrupt(cell, virus, created_cells, create_limit);
-
-          std::swap(*it, state.viruses.back()); // O(1) removal
-          state.viruses.pop_back();
-          return true; // only collide once
-        } else ++it;
+    /**
+     * finds the viruses that each of the given cells can eat, as (cell, virus)
+     * pairs in `reached`, among those in the buckets of the virus index that
+     * the cell overlaps (a cell can only eat a virus smaller than itself, so
+     * its radius bounds the search)
+     */
+    void find_reached_viruses(const std::vector<Cell> &cells, std::vector<std::pair<int, int>> &reached,
+                              Profiler &profiler) const {
+      reached.clear();
+      for (int c = 0; c < static_cast<int>(cells.size()); c++) {
+        auto &cell = cells[c];
+        state.virus_index.for_each_near(cell.x, cell.y, cell.radius(), [&](int v) {
+          profiler.count(profile::virus_candidates);
+          if (can_eat(cell, state.viruses, v))
+            reached.emplace_back(c, v);
+        });
       }
-      return false;
     }
 
-    void initialize_virus_grid()
-    {
-      virus_grid_size = 25;
-      virus_grid_width = (state.config.arena_width + virus_grid_size - 1) / virus_grid_size;
-      virus_grid_height = (state.config.arena_height + virus_grid_size - 1) / virus_grid_size;
-      virus_grid.resize(virus_grid_width * virus_grid_height);
-
-      for (int i = 0; i < state.viruses.size(); ++i) {
-        const Virus &virus = state.viruses[i];
-        int grid_x = static_cast<int>(virus.x) / virus_grid_size;
-        int grid_y = static_cast<int>(virus.y) / virus_grid_size;
-        virus_grid[grid_y * virus_grid_width + grid_x].push_back(i);
-      }
-
-    }
-
-    bool optimized_check_virus_collisions(std::vector<Cell> &cells, std::vector<Cell> &created_cells, int create_limit, bool can_eat_virus, std::vector<int>& viruses_to_remove) {
-
-      // Check for collisions
-      for (Cell &cell : cells) {
-        int grid_x = static_cast<int>(cell.x) / virus_grid_size;
-        int grid_y = static_cast<int>(cell.y) / virus_grid_size;
-
-        // Check the cell's grid and neighboring grids
-        for (int dx = -1; dx <= 1; ++dx) {
-          for (int dy = -1; dy <= 1; ++dy) {
-            int nx = grid_x + dx;
-            int ny = grid_y + dy;
-            if (nx >= 0 && nx < virus_grid_width && ny >= 0 && ny < virus_grid_height) {
-              for (int virus_idx : virus_grid[ny * virus_grid_width + nx]) {
-                Virus &virus = state.viruses[virus_idx];
-                if (cell.can_eat(virus) && cell.collides_with(virus)) {
-              if (can_eat_virus)
-                cell.increment_mass(virus.mass());
-              else
-                disrupt(cell, virus, created_cells, create_limit);
-              viruses_to_remove.push_back(virus_idx);
-              return true; // only collide once
-                }
-              }
-            }
-          }
+    /**
+     * the first of the player's cells to reach a virus that no player has hit
+     * yet this tick eats the lowest-indexed such virus, or is disrupted by it,
+     * and the virus is appended to `viruses_to_remove`. A player hits at most
+     * one virus per tick, and each virus is hit by at most one player.
+     */
+    void hit_virus(Player &player, PlayerTick &tick, std::vector<int> &viruses_to_remove) {
+      if (virus_hit_.size() < state.viruses.size())
+        virus_hit_.resize(state.viruses.size(), false);
+
+      int cell_idx = -1;
+      int virus_idx = -1;
+      for (auto [c, v] : tick.viruses_reached) {
+        if (cell_idx >= 0 && c != cell_idx) break; // only collide once
+        if (virus_hit_[v]) continue;
+        if (virus_idx < 0 || v < virus_idx) {
+          cell_idx = c;
+          virus_idx = v;
         }
       }
-      return false;
+      if (virus_idx < 0) return;
+
+      Cell &cell = player.cells[cell_idx];
+      if (tick.can_eat_virus)
+        cell.increment_mass(state.viruses.mass(virus_idx));
+      else
+        disrupt(cell, state.viruses.location(virus_idx), tick.created_cells, tick.create_limit);
+      virus_hit_[virus_idx] = true;
+      viruses_to_remove.push_back(virus_idx);
+      player.virus_eaten_ticks.emplace_back(player.elapsed_ticks);
+      player.viruses_eaten++;
     }
-    void remove_viruses(const std::vector<int>& viruses_to_remove) {
+
+    /**
+     * removes the given viruses from the game, updating the virus index in place,
+     * from the highest index down (as in remove_pellets) and once each
+     */
+    void remove_viruses(std::vector<int> &viruses_to_remove) {
+      std::sort(viruses_to_remove.begin(), viruses_to_remove.end(), std::greater<int>());
+      viruses_to_remove.erase(std::unique(viruses_to_remove.begin(), viruses_to_remove.end()),
+                              viruses_to_remove.end());
       for (int idx : viruses_to_remove) {
-        if (idx < state.viruses.size() - 1 && state.viruses.size() > 1)
-          std::swap(state.viruses[idx], state.viruses.back());
-        if (state.viruses.size() >= 1)
-          state.viruses.pop_back();
+        virus_hit_[idx] = false;
+        state.virus_index.erase(idx);
+        state.viruses.swap_remove(idx);
       }
     }
-    /* called when `cell` collides with `virus` and is popped/disrupted.
+    /* called when `cell` collides with the virus at `virus_loc` and is popped/disrupted.
      * The new cells that are created are added to `created_cells */
-    void disrupt(Cell &cell, Virus &virus, std::vector<Cell> &created_cells, int create_limit) {
+    void disrupt(Cell &cell, const Location &virus_loc, std::vector<Cell> &created_cells, int create_limit) {
       agario::mass total_mass = cell.mass(); // mass to conserve
 
       // reduce the cell by roughly this ratio CELL_POP_REDUCTION, making sure the
@@ -1283,14 +1822,18 @@ namespace agario {
         auto vel = Velocity(theta + dvel_angle, max_speed(CELL_POP_SIZE));
         auto new_cell_mass = std::min<mass>(remaining_mass, CELL_POP_SIZE);
 
-        auto loc = virus.location();
-        Cell new_cell(loc, cell.velocity, new_cell_mass);
+        Cell new_cell(virus_loc, cell.velocity, new_cell_mass);
         new_cell.splitting_velocity = vel;
-        new_cell.reset_recombine_timer();
+        reset_recombine_timer(new_cell);
         created_cells.emplace_back(std::move(new_cell));
         remaining_mass -= new_cell_mass;
       }
-      cell.reset_recombine_timer();
+      reset_recombine_timer(cell);
+    }
+
+    /* starts the recombine timer of `cell`, in game ticks rather than wall-clock time */
+    void reset_recombine_timer(Cell &cell) {
+      cell.reset_recombine_timer(state.ticks, recombine_ticks_);
     }
 
     float split_speed(agario::mass mass) {
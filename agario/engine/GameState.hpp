@@ -2,10 +2,14 @@
 
 #include "agario/core/Ball.hpp"
 #include "agario/core/Entities.hpp"
+#include "agario/core/EntityStore.hpp"
 #include "agario/core/Player.hpp"
+#include "agario/core/settings.hpp"
+#include "agario/utils/spatial_index.hpp"
+#include "agario/utils/random.hpp"
 
 #include <vector>
-#include <unordered_map>
+#include <map>
 #include <iomanip>
 #include <memory>
 #include <random>
@@ -41,29 +45,83 @@ namespace agario {
   template<bool renderable>
   class GameState {
   public:
-    using PlayerMap = std::unordered_map<agario::pid, std::shared_ptr<agario::Player<renderable>>>;
+    // ordered by pid, which is the order that players take their turns in, so
+    // that games, clones and replays play out the same wherever they're run
+    using PlayerMap = std::map<agario::pid, std::shared_ptr<agario::Player<renderable>>>;
+    using Pellets = agario::EntityStore<agario::Pellet<renderable>, renderable>;
+    using Foods = agario::EntityStore<agario::Food<renderable>, renderable>;
+    using Viruses = agario::EntityStore<agario::Virus<renderable>, renderable>;
 
     PlayerMap players;
-    std::vector<agario::Pellet<renderable>> pellets;
-    std::vector<agario::Food<renderable>> foods;
-    std::vector<agario::Virus<renderable>> viruses;
+    Pellets pellets;
+    Foods foods;
+    Viruses viruses;
+
+    /* persistent indexes over `pellets`, `foods` and `viruses`, kept in sync by the engine */
+    agario::SpatialHash pellet_index;
+    agario::SpatialHash food_index;
+    agario::SpatialHash virus_index;
+
+    /* the foods that are still moving, in increasing order. The rest are at rest until they're eaten */
+    std::vector<int> moving_foods;
+
     agario::pid main_agent_pid;
-    std::mt19937_64 rng;
+    agario::Rng rng;
+    agario::R2Sequence spawn_sequence; // where pellets and viruses are placed, with low-discrepancy spawns
+
+    /* eaten pellets and viruses still to be regenerated, a budget's worth per tick (see Engine::set_regen_budget) */
+    int pending_pellets = 0;
+    int pending_viruses = 0;
     agario::tick ticks = 0;
     agario::pid next_pid = 0;
 
     agario::GameConfig config;
 
     explicit GameState (const agario::GameConfig &c) :
-      config(c),
-      rng(std::random_device{}())
+      pellet_index(c.arena_width, c.arena_height, SPATIAL_HASH_BUCKET_SIZE),
+      food_index(c.arena_width, c.arena_height, SPATIAL_HASH_BUCKET_SIZE),
+      virus_index(c.arena_width, c.arena_height, SPATIAL_HASH_BUCKET_SIZE),
+      rng(std::random_device{}()),
+      config(c)
     { }
 
+    /**
+     * makes this state a deep copy of `other`, whose config must match: each
+     * player is cloned (keeping its bot type) and the entity stores are
+     * copied into the storage this state already holds
+     */
+    void copy_from(const GameState &other) {
+      players = other.players;
+      for (auto &pair : players)
+        pair.second = pair.second->clone();
+
+      pellets = other.pellets;
+      foods = other.foods;
+      viruses = other.viruses;
+      pellet_index = other.pellet_index;
+      food_index = other.food_index;
+      virus_index = other.virus_index;
+      moving_foods = other.moving_foods;
+      main_agent_pid = other.main_agent_pid;
+      rng = other.rng;
+      spawn_sequence = other.spawn_sequence;
+      pending_pellets = other.pending_pellets;
+      pending_viruses = other.pending_viruses;
+      ticks = other.ticks;
+      next_pid = other.next_pid;
+    }
+
     void clear() {
       players.clear();
       pellets.clear();
+      pellet_index.clear();
       foods.clear();
+      food_index.clear();
+      moving_foods.clear();
       viruses.clear();
+      virus_index.clear();
+      pending_pellets = 0;
+      pending_viruses = 0;
       ticks = 0;
     }
   };
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "agario/engine/Engine.hpp"
+
+namespace agario {
+
+  /**
+   * Runs single phases of an engine's tick on their own, which the
+   * benchmarks and tests use to measure and check them in isolation.
+   * Not for use by games, which should only advance with Engine::tick.
+   */
+  struct EngineInternals {
+
+    /* moves the engine's foods, as a tick does (see Engine::move_foods) */
+    template<typename Engine>
+    static void move_foods(Engine &engine, const agario::time_delta &elapsed_seconds) {
+      engine.move_foods(elapsed_seconds);
+    }
+
+    /* pushes apart the overlapping cells of `player` (see Engine::check_player_self_collisions) */
+    template<typename Engine>
+    static void check_player_self_collisions(Engine &engine, typename Engine::Player &player,
+                                             const agario::time_delta &elapsed_seconds) {
+      engine.check_player_self_collisions(player, elapsed_seconds);
+    }
+
+  };
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+namespace agario {
+
+  /**
+   * The rules of a game mode that matter within a tick, as compile-time
+   * traits. Engine::tick picks the instantiation of its tick for the current
+   * mode's rules once per tick, so that the rules that are disabled are
+   * compiled out of the tick rather than checked for every player.
+   * @tparam MassDecay whether cells lose mass over time (and anti-team applies)
+   * @tparam RegenPellets whether eaten pellets and viruses grow back
+   */
+  template<bool MassDecay, bool RegenPellets>
+  struct TickRules {
+    static constexpr bool mass_decay = MassDecay;
+    static constexpr bool regen_pellets = RegenPellets;
+  };
+
+  namespace mode {
+    using Standard = TickRules<true, true>;          // modes 0, 4 and 6, and the mini-games 7-10
+    using NoRegen = TickRules<true, false>;          // modes 2 and 5
+    using NoDecay = TickRules<false, true>;          // mode 3
+    using NoDecayNoRegen = TickRules<false, false>;  // mode 1
+  }
+
+  /* the rules of a game mode, which an engine takes on from the mode's number (see Engine::set_mode) */
+  struct GameMode {
+    bool mass_decay = true;
+    bool regen_pellets = true;
+    bool squared_pellets = false; // whether pellets are laid out in a square, rather than at random
+    int agent_mass = 25;          // the mass with which players spawn
+  };
+
+}
@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 
+#ifdef AGARIO_PROFILE
+#include <agario/utils/count_allocations.hpp>
+#endif
+
 #include <agario/test/test-core.hpp>
 #include <agario/test/test-entities.hpp>
 #include <agario/test/test-engine.hpp>
+#include <agario/test/test-utils.hpp>
 
 namespace { }
 
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <gtest/gtest.h>
+#include <thread>
+#include <typeinfo>
 
 #include <agario/engine/Engine.hpp>
+#include <agario/engine/internals.hpp>
 #include <agario/test/renderable.hpp>
 
 namespace {
@@ -194,6 +197,468 @@ namespace {
     }
   }
 
+  TEST(Engine, PlayersEatCells) {
+    using Player = agario::Player<renderable>;
+    agario::Engine<renderable> engine(500, 500, 0, 0);
+    engine.reset();
+
+    auto &big = engine.player(engine.add_player<Player>("Big"));
+    auto &small = engine.player(engine.add_player<Player>("Small"));
+    big.kill();
+    small.kill();
+
+    big.add_cell(agario::Location(250, 250), 400);
+    small.add_cell(agario::Location(255, 250), 30); // inside of the big cell
+    small.add_cell(agario::Location(50, 50), 30);   // far away
+    big.target = big.location();
+    small.target = small.location();
+
+    engine.tick(agario::time_delta(1.0 / 60));
+
+    ASSERT_EQ(small.cells.size(), 1ul) << "Overlapping cell was not eaten";
+    EXPECT_LT(small.cells.front().x, 100) << "Wrong cell was eaten";
+    EXPECT_EQ(big.cells.size(), 1ul);
+    EXPECT_EQ(big.mass(), 430u) << "Eaten mass not given to the eater";
+    EXPECT_EQ(big.cells_eaten, 1);
+  }
+
+  /* cells eat the foods that they overlap, and moving foods feed the viruses that they hit */
+  TEST(Engine, FoodsEatenAndFedToViruses) {
+    using Player = agario::Player<renderable>;
+    agario::Engine<renderable> engine(500, 500, 0, 0);
+    engine.reset();
+
+    auto &player = engine.player(engine.add_player<Player>("Player"));
+    player.kill();
+    player.add_cell(agario::Location(250, 250), 400);
+    player.target = player.location();
+
+    auto &foods = engine.state.foods;
+    for (float x : {50.0f, 248.0f, 252.0f, 450.0f, 250.0f})
+      foods.emplace_back(agario::Location(x, x == 50 || x == 450 ? 50 : 250), agario::Velocity());
+    engine.tick(agario::time_delta(1.0 / 60));
+
+    ASSERT_EQ(engine.food_count(), 2) << "Overlapping foods were not eaten";
+    EXPECT_FLOAT_EQ(foods.x(0), 50) << "Uneaten foods did not keep their order";
+    EXPECT_FLOAT_EQ(foods.x(1), 450);
+    EXPECT_EQ(player.food_eaten, 3);
+    EXPECT_EQ(player.mass(), 400u + 3 * FOOD_MASS);
+
+    // each food shot at the virus feeds it, until it splits off a new virus
+    auto &viruses = engine.state.viruses;
+    viruses.emplace_back(agario::Location(100, 400), agario::Velocity());
+    for (int shot = 0; shot <= NUMBER_OF_FOOD_HITS; shot++) {
+      foods.emplace_back(agario::Location(80, 400), agario::Velocity(agario::distance(FOOD_SPEED), agario::distance(0)));
+      for (int t = 0; t < 60 && engine.food_count() > 2; t++)
+        agario::EngineInternals::move_foods(engine, agario::time_delta(1.0 / 60));
+      ASSERT_EQ(engine.food_count(), 2) << "Food passed through the virus";
+      if (shot < NUMBER_OF_FOOD_HITS) {
+        EXPECT_EQ(viruses.mass(0), VIRUS_INITIAL_MASS + (shot + 1) * FOOD_MASS);
+      }
+    }
+    ASSERT_EQ(engine.virus_count(), 2) << "Fed virus did not split";
+    EXPECT_EQ(viruses.mass(0), VIRUS_INITIAL_MASS);
+    EXPECT_GT(viruses.x(1), viruses.x(0)) << "New virus not shot in the food's direction";
+
+    // the indexes still hold every food and virus where it is
+    auto indexed = [](const agario::SpatialHash &index, float x, float y, int id) {
+      bool found = false;
+      index.for_each_near(x, y, 0, [&](int i) { found |= i == id; });
+      return found;
+    };
+    for (int i = 0; i < static_cast<int>(foods.size()); i++)
+      EXPECT_TRUE(indexed(engine.state.food_index, foods.x(i), foods.y(i), i)) << "food " << i << " not indexed";
+    for (int v = 0; v < static_cast<int>(viruses.size()); v++)
+      EXPECT_TRUE(indexed(engine.state.virus_index, viruses.x(v), viruses.y(v), v)) << "virus " << v << " not indexed";
+  }
+
+  /* the engine keeps track of which foods are moving, and leaves the foods at rest alone */
+  TEST(Engine, FoodsComeToRest) {
+    using Player = agario::Player<renderable>;
+    agario::Engine<renderable> engine(500, 500, 100, 10);
+    engine.seed(1);
+    engine.reset();
+
+    std::vector<Player *> feeders;
+    for (int i = 0; i < 5; i++) {
+      auto &player = engine.player(engine.add_player<Player>("Feeder"));
+      player.cells.front().set_mass(2000);
+      player.target = engine.random_location();
+      player.action = agario::action::feed;
+      feeders.push_back(&player);
+    }
+    for (int i = 0; i < 5; i++)
+      engine.add_player<agario::bot::HungryBot<renderable>>("HungryBot");
+
+    auto &foods = engine.state.foods;
+    auto moving_foods = [&foods]() {
+      std::vector<int> moving;
+      for (int i = 0; i < static_cast<int>(foods.size()); i++)
+        if (foods.velocity(i).magnitude() != 0)
+          moving.push_back(i);
+      return moving;
+    };
+
+    // while foods are emitted, eaten and shot into viruses
+    for (int t = 0; t < 300; t++) {
+      engine.tick(agario::time_delta(1.0 / 60));
+      ASSERT_EQ(engine.state.moving_foods, moving_foods()) << "moving foods out of sync at tick " << t;
+    }
+    ASSERT_GT(engine.food_count(), 0);
+
+    // once the feeding stops, every food comes to rest and stays put
+    for (auto *feeder : feeders)
+      feeder->action = agario::action::none;
+    for (int t = 0; t < 300; t++)
+      engine.tick(agario::time_delta(1.0 / 60));
+    EXPECT_TRUE(engine.state.moving_foods.empty()) << "foods did not come to rest";
+
+    std::vector<float> xs;
+    for (int i = 0; i < static_cast<int>(foods.size()); i++)
+      xs.push_back(foods.x(i));
+    agario::EngineInternals::move_foods(engine, agario::time_delta(1.0 / 60));
+    for (int i = 0; i < static_cast<int>(foods.size()); i++)
+      EXPECT_EQ(foods.x(i), xs[i]) << "food at rest was moved";
+  }
+
+  /* regeneration adds at most a budget's worth of pellets and viruses per tick, pellets first */
+  TEST(Engine, RegenBudget) {
+    agario::Engine<renderable> engine(1000, 1000, 2000, 10);
+    engine.seed(0);
+    engine.reset();
+    EXPECT_EQ(engine.regen_budget(), 0);
+    EXPECT_THROW(engine.set_regen_budget(-1), agario::EngineException);
+
+    auto empty_arena = [&engine]() {
+      auto &state = engine.state;
+      state.pellets.clear();
+      state.pellet_index.clear();
+      state.viruses.clear();
+      state.virus_index.clear();
+    };
+
+    // without a budget, the arena is refilled all at once
+    empty_arena();
+    engine.tick(agario::time_delta(1.0 / 60));
+    EXPECT_EQ(engine.pellet_count(), 2000);
+    EXPECT_EQ(engine.virus_count(), 10);
+
+    engine.set_regen_budget(150);
+    for (int t = 1; t < REGEN_INTERVAL_TICKS; t++)
+      engine.tick(agario::time_delta(1.0 / 60));
+    empty_arena();
+    for (int t = 1; t <= 14; t++) {
+      engine.tick(agario::time_delta(1.0 / 60));
+      ASSERT_EQ(engine.pellet_count(), std::min(150 * t, 2000)) << "wrong number of pellets after " << t << " ticks";
+      ASSERT_EQ(engine.virus_count(), t < 14 ? 0 : 10) << "viruses regenerated before the pellets";
+    }
+    engine.tick(agario::time_delta(1.0 / 60));
+    EXPECT_EQ(engine.pellet_count(), 2000);
+    EXPECT_EQ(engine.virus_count(), 10);
+
+    // the pellet index keeps up with the regenerated pellets
+    auto &pellets = engine.state.pellets;
+    int indexed = 0;
+    engine.state.pellet_index.for_each_in(0, 0, 1000, 1000, [&indexed](int) { indexed++; });
+    EXPECT_EQ(indexed, pellets.size());
+  }
+
+  /* low-discrepancy spawns cover the arena evenly, and are as reproducible as random ones */
+  TEST(Engine, LowDiscrepancySpawns) {
+    auto spawn = [](unsigned seed) {
+      auto engine = std::make_unique<agario::Engine<renderable>>(1000, 1000, 1000, 10);
+      engine->set_low_discrepancy_spawns(true);
+      engine->seed(seed);
+      engine->reset();
+      return engine;
+    };
+
+    auto engine = spawn(3);
+    EXPECT_TRUE(engine->low_discrepancy_spawns());
+    auto &pellets = engine->pellets();
+    std::vector<int> counts(100, 0); // pellets in each square of a 10x10 grid over the arena
+    for (int i = 0; i < static_cast<int>(pellets.size()); i++) {
+      ASSERT_GE(pellets.x(i), 0);
+      ASSERT_LE(pellets.x(i), 1000);
+      counts[static_cast<int>(pellets.y(i) / 100) * 10 + static_cast<int>(pellets.x(i) / 100)]++;
+    }
+    EXPECT_GE(*std::min_element(counts.begin(), counts.end()), 7) << "pellets are not spread evenly";
+    EXPECT_LE(*std::max_element(counts.begin(), counts.end()), 13) << "pellets are not spread evenly";
+
+    EXPECT_EQ(engine->state_hash(), spawn(3)->state_hash()) << "equal seeds spawned differently";
+    EXPECT_NE(engine->state_hash(), spawn(4)->state_hash()) << "the sequence does not start from the seed";
+  }
+
+  /* a player's own cells are pushed apart, only visiting the pairs that are near one another */
+  TEST(Engine, SelfCollisionsSeparateCells) {
+    using Player = agario::Player<renderable>;
+    agario::Engine<renderable> engine(1000, 1000, 0, 0);
+    engine.reset();
+    auto &player = engine.player(engine.add_player<Player>("Player"));
+    player.cells.clear();
+
+    auto touching_pairs = [&player]() {
+      int pairs = 0;
+      for (std::size_t a = 0; a < player.cells.size(); a++)
+        for (std::size_t b = a + 1; b < player.cells.size(); b++)
+          pairs += player.cells[a].touches(player.cells[b]);
+      return pairs;
+    };
+
+    // two overlapping cells, and one far away from both
+    player.add_cell(agario::Location(500, 500), 100);
+    player.add_cell(agario::Location(505, 500), 100);
+    player.add_cell(agario::Location(100, 900), 100);
+    player.target = agario::Location(500, 500);
+    agario::EngineInternals::check_player_self_collisions(engine, player, agario::time_delta(1.0 / 60));
+    EXPECT_EQ(touching_pairs(), 0) << "overlapping cells were not pushed apart";
+    EXPECT_FLOAT_EQ(player.cells[2].x, 100) << "a cell that touched no other was moved";
+    EXPECT_FLOAT_EQ(player.cells[2].y, 900);
+
+    // a clump of 32 cells is untangled over several ticks
+    agario::Rng rng(0);
+    std::uniform_real_distribution<float> offset(-30, 30);
+    player.cells.clear();
+    for (int c = 0; c < 32; c++)
+      player.add_cell(agario::Location(500 + offset(rng), 500 + offset(rng)), 100);
+    int before = touching_pairs();
+    engine.set_self_collision_iterations(20);
+    for (int t = 0; t < 30; t++)
+      agario::EngineInternals::check_player_self_collisions(engine, player, agario::time_delta(1.0 / 60));
+    EXPECT_LT(touching_pairs(), before * 2 / 3);
+
+    EXPECT_EQ(engine.self_collision_iterations(), 20);
+    EXPECT_THROW(engine.set_self_collision_iterations(0), agario::EngineException);
+  }
+
+  /* recombining is timed in game ticks, however fast the engine runs */
+  TEST(Engine, RecombineAfterTimerTicks) {
+    using Player = agario::Player<renderable>;
+    agario::Engine<renderable> engine(1000, 1000, 0, 0);
+    engine.reset();
+
+    auto &player = engine.player(engine.add_player<Player>("TestPlayer"));
+    player.kill();
+    player.add_cell(agario::Location(500, 500), 200);
+    player.target = agario::Location(900, 500);
+    player.action = agario::action::split;
+
+    agario::time_delta dt(1.0 / 30);
+    engine.tick(dt);
+    ASSERT_EQ(player.cells.size(), 2ul) << "Player did not split";
+
+    auto split_tick = engine.ticks() - 1;
+    auto timer_ticks = static_cast<agario::tick>(std::ceil(RECOMBINE_TIMER_SEC / dt.count()));
+    for (auto &cell : player.cells) {
+      EXPECT_FALSE(cell.can_recombine(split_tick + timer_ticks - 1));
+      EXPECT_TRUE(cell.can_recombine(split_tick + timer_ticks));
+    }
+  }
+
+  /* seeds and resets `engine`, and adds the bots that the seeded games below are played by */
+  template<typename Engine>
+  void start_seeded_game(Engine &engine, unsigned seed) {
+    engine.seed(seed);
+    engine.reset();
+    engine.template add_player<agario::bot::HungryBot<renderable>>("HungryBot");
+    engine.template add_player<agario::bot::AggressiveBot<renderable>>("AggressiveBot");
+    engine.template add_player<agario::bot::HungryShyBot<renderable>>("HungryShyBot");
+  }
+
+  /* ticks `engine` `num_ticks` times at 60 ticks per second, returning the hash of its state */
+  template<typename Engine>
+  std::uint64_t play_ticks(Engine &engine, int num_ticks) {
+    for (int i = 0; i < num_ticks; i++)
+      engine.tick(agario::time_delta(1.0 / 60));
+    return engine.state_hash();
+  }
+
+  /* two games with the same seed play out identically, bots included */
+  TEST(Engine, SeededGamesReproduce) {
+    auto play = [](unsigned seed) {
+      agario::Engine<renderable> engine(500, 500, 200, 5);
+      start_seeded_game(engine, seed);
+      return play_ticks(engine, 200);
+    };
+
+    EXPECT_EQ(play(42), play(42)) << "Games with equal seeds diverged";
+    EXPECT_NE(play(42), play(43)) << "Games with different seeds were identical";
+  }
+
+  /* the hash of a game of mode `mode_number` */
+  std::uint64_t play_mode(int mode_number) {
+    agario::Engine<renderable> engine(500, 500, 200, 5, true, mode_number);
+    start_seeded_game(engine, 42);
+    return play_ticks(engine, 400);
+  }
+
+  /* each game mode ticks with its own rules */
+  TEST(Engine, Modes) {
+    EXPECT_EQ(play_mode(0), play_mode(4)) << "modes with the same rules played out differently";
+    EXPECT_NE(play_mode(0), play_mode(3)) << "modes without decay played out the same";
+    EXPECT_NE(play_mode(0), play_mode(6)) << "agents of mode 6 did not spawn heavier";
+    EXPECT_NE(play_mode(1), play_mode(2)) << "squared-pellet modes with and without decay played out the same";
+    EXPECT_THROW(play_mode(11), agario::EngineException);
+  }
+
+  /* a cloned game (and one copied into an existing engine) plays out exactly as the original does, on a pool too */
+  TEST(Engine, ClonesPlayOutIdentically) {
+    using Engine = agario::Engine<renderable>;
+    for (int num_threads : {1, 4}) {
+      Engine engine(500, 500, 200, 5);
+      engine.set_num_threads(num_threads);
+      start_seeded_game(engine, 42);
+      engine.add_player<agario::Player<renderable>>("agent");
+      play_ticks(engine, 100);
+
+      auto clone = engine.clone();
+      Engine copy(500, 500, 200, 5);
+      copy.copy_state_from(engine);
+
+      for (auto *game : {clone.get(), &copy}) {
+        EXPECT_EQ(game->state_hash(), engine.state_hash());
+        EXPECT_EQ(game->num_threads(), num_threads);
+        for (auto &[pid, player] : engine.players())
+          EXPECT_EQ(typeid(*player), typeid(game->get_player(pid))) << "player " << pid << " lost its type";
+      }
+
+      auto expected = play_ticks(engine, 200);
+      EXPECT_EQ(play_ticks(*clone, 200), expected) << "cloned game diverged on " << num_threads << " threads";
+      EXPECT_EQ(play_ticks(copy, 200), expected) << "copied game diverged on " << num_threads << " threads";
+
+      Engine other(400, 500, 200, 5);
+      EXPECT_THROW(other.copy_state_from(engine), agario::EngineException);
+    }
+  }
+
+  /* players ticked on a pool play out exactly the same on any number of threads */
+  TEST(Engine, ParallelTickMatchesAcrossThreads) {
+    using Engine = agario::Engine<renderable, true>;
+    auto play = [](Engine &engine) {
+      engine.seed(7);
+      engine.reset();
+      for (int i = 0; i < 32; i++) {
+        switch (i % 4) {
+          case 0: engine.add_player<agario::bot::HungryBot<renderable>>("HungryBot"); break;
+          case 1: engine.add_player<agario::bot::HungryShyBot<renderable>>("HungryShyBot"); break;
+          case 2: engine.add_player<agario::bot::AggressiveBot<renderable>>("AggressiveBot"); break;
+          case 3: engine.add_player<agario::bot::AggressiveShyBot<renderable>>("AggressiveShyBot"); break;
+        }
+      }
+      std::vector<std::uint64_t> hashes;
+      for (int i = 0; i < 600; i++) {
+        engine.tick(agario::time_delta(1.0 / 60));
+        if (i % 50 == 0) hashes.push_back(engine.state_hash());
+      }
+      return hashes;
+    };
+
+    // a small arena, so that players often reach the same pellets
+    Engine two(400, 400, 500, 5);
+    Engine parallel(400, 400, 500, 5);
+    two.set_num_threads(2);
+    parallel.set_num_threads(4);
+    EXPECT_EQ(parallel.num_threads(), 4);
+    EXPECT_EQ(play(two), play(parallel)) << "parallel tick diverged across thread counts";
+
+    auto profile = parallel.profile();
+    EXPECT_EQ(profile["move.calls"], two.profile()["move.calls"]) << "worker threads' profiles were lost";
+    EXPECT_EQ(profile["pellet_candidates"], two.profile()["pellet_candidates"]);
+
+    EXPECT_THROW(parallel.set_num_threads(0), agario::EngineException);
+  }
+
+  /* each virus is hit by at most one player, on one thread or several */
+  TEST(Engine, VirusHitOnce) {
+    using Player = agario::Player<renderable>;
+    for (int num_threads : {1, 4}) {
+      agario::Engine<renderable> engine(500, 500, 0, 0);
+      engine.set_num_threads(num_threads);
+      engine.reset();
+
+      auto &viruses = engine.state.viruses;
+      for (auto [x, y] : {std::pair(100, 100), {400, 100}, {250, 250}, {400, 400}})
+        viruses.emplace_back(agario::Location(x, y), agario::Velocity());
+
+      std::vector<Player *> players;
+      for (auto [x, y] : {std::pair(245, 250), {255, 250}, {400, 400}, {100, 100}}) {
+        auto &player = engine.player(engine.add_player<Player>("Player"));
+        player.kill();
+        player.add_cell(agario::Location(x, y), 400);
+        player.target = player.location();
+        players.push_back(&player);
+      }
+      engine.tick(agario::time_delta(1.0 / 60));
+
+      // the first and last viruses go along with the one that two players reached
+      ASSERT_EQ(engine.virus_count(), 1) << "Wrong viruses removed on " << num_threads << " threads";
+      EXPECT_FLOAT_EQ(viruses.x(0), 400);
+      EXPECT_FLOAT_EQ(viruses.y(0), 100);
+      EXPECT_EQ(players[0]->viruses_eaten + players[1]->viruses_eaten, 1) << "Virus hit by both players";
+      EXPECT_EQ(players[2]->viruses_eaten, 1);
+      EXPECT_EQ(players[3]->viruses_eaten, 1);
+    }
+  }
+
+  /* profiled engines account for each phase of the tick */
+  TEST(Engine, Profile) {
+    agario::Engine<renderable, true> engine(500, 500, 200, 5);
+    engine.seed(0);
+    engine.reset();
+    engine.add_player<agario::bot::HungryBot<renderable>>("HungryBot");
+    engine.add_player<agario::bot::AggressiveBot<renderable>>("AggressiveBot");
+    for (int i = 0; i < 100; i++)
+      engine.tick(agario::time_delta(1.0 / 60));
+
+    auto profile = engine.profile();
+    EXPECT_EQ(profile["ticks"], 100);
+    EXPECT_EQ(profile["players"], 2);
+    EXPECT_GT(profile["cells"], 0);
+    EXPECT_EQ(profile["pellets"], engine.pellet_count());
+    EXPECT_EQ(profile["move.calls"], 200) << "move was not timed once per player per tick";
+    EXPECT_EQ(profile["players_collision.calls"], 100);
+    EXPECT_GT(profile["move.seconds"], 0);
+    EXPECT_GT(profile["pellet_candidates"], 0);
+
+    engine.reset_profile();
+    EXPECT_EQ(engine.profile()["ticks"], 0);
+
+    agario::Engine<renderable> unprofiled(500, 500, 200, 5);
+    unprofiled.tick(agario::time_delta(1.0 / 60));
+    EXPECT_TRUE(unprofiled.profile().empty());
+  }
+
+  /* separate engines can be run on separate threads */
+  TEST(Engine, ConcurrentEngines) {
+    using Player = agario::Player<renderable>;
+    constexpr int num_threads = 4;
+
+    std::vector<std::vector<int>> cell_ids(num_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([t, &cell_ids]() {
+        agario::Engine<renderable> engine(500, 500, 100, 5);
+        engine.seed(t);
+        engine.reset();
+        for (int i = 0; i < 20; i++)
+          engine.add_player<Player>("Player" + std::to_string(i));
+        for (int i = 0; i < 50; i++)
+          engine.tick(agario::time_delta(1.0 / 60));
+        for (auto &pair : engine.players())
+          for (auto &cell : pair.second->cells)
+            cell_ids[t].push_back(cell.id);
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+
+    std::vector<int> all_ids;
+    for (auto &ids : cell_ids)
+      all_ids.insert(all_ids.end(), ids.begin(), ids.end());
+    std::sort(all_ids.begin(), all_ids.end());
+    EXPECT_EQ(std::adjacent_find(all_ids.begin(), all_ids.end()), all_ids.end()) << "Cell ids were not unique";
+  }
+
   // todo: more trixy tests
 
 }
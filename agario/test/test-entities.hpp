@@ -56,6 +56,68 @@ namespace {
         }
   }
 
+  TEST(Cell, RecombineTimer) {
+    agario::Cell<renderable> cell(agario::Location(10, 10), 50);
+    EXPECT_TRUE(cell.can_recombine(0)) << "New cell cannot recombine";
+
+    cell.reset_recombine_timer(100, 30);
+    EXPECT_FALSE(cell.can_recombine(100));
+    EXPECT_FALSE(cell.can_recombine(129));
+    EXPECT_TRUE(cell.can_recombine(130)) << "Cell cannot recombine after its timer";
+  }
+
+  /* =========== EntityStore =========== */
+
+  TEST(EntityStore, Pellets) {
+    typename agario::GameState<renderable>::Pellets pellets;
+    for (int i = 0; i < 5; i++)
+      pellets.emplace_back(agario::Location(i, 2 * i));
+
+    ASSERT_EQ(pellets.size(), 5ul);
+    EXPECT_EQ(pellets.mass(3), PELLET_MASS);
+    EXPECT_FLOAT_EQ(pellets.radius(3), agario::radius_conversion(PELLET_MASS));
+
+    pellets.swap_remove(1);
+    ASSERT_EQ(pellets.size(), 4ul);
+    EXPECT_FLOAT_EQ(pellets.x(1), 4) << "Last pellet was not moved into the removed slot";
+    EXPECT_FLOAT_EQ(pellets.y(1), 8);
+
+    int i = 0;
+    for (const auto &pellet : pellets) {
+      EXPECT_EQ(pellet.location(), pellets.location(i));
+      EXPECT_EQ(pellet.mass(), pellets.mass(i));
+      i++;
+    }
+    EXPECT_EQ(i, 4);
+  }
+
+  TEST(EntityStore, Viruses) {
+    typename agario::GameState<renderable>::Viruses viruses;
+    for (int i = 0; i < 6; i++)
+      viruses.emplace_back(agario::Location(10 * i, 0), agario::Velocity(agario::distance(i), agario::distance(-i)));
+
+    EXPECT_EQ(viruses.mass(0), VIRUS_INITIAL_MASS);
+    EXPECT_FLOAT_EQ(viruses.radius(0), agario::radius_conversion(VIRUS_INITIAL_MASS));
+
+    viruses.set_mass(2, 250);
+    viruses.set_food_hits(2, 3);
+    EXPECT_EQ(viruses.mass(2), 250u);
+    EXPECT_FLOAT_EQ(viruses.radius(2), agario::radius_conversion(250)) << "Radius not updated with mass";
+    EXPECT_EQ(viruses[2].get_num_food_hits(), 3);
+    EXPECT_FLOAT_EQ(viruses.velocity(2).dx, 2);
+
+    // removing the odd viruses keeps the rest in order
+    auto removed = viruses.remove_if([&](int i) { return static_cast<int>(viruses.x(i)) % 20 != 0; });
+    EXPECT_EQ(removed, 3);
+    ASSERT_EQ(viruses.size(), 3ul);
+    for (int i = 0; i < 3; i++) {
+      EXPECT_FLOAT_EQ(viruses.x(i), 20 * i);
+      EXPECT_FLOAT_EQ(viruses.velocity(i).dy, -2 * i);
+    }
+    EXPECT_EQ(viruses.mass(1), 250u);
+    EXPECT_EQ(viruses.food_hits(1), 3);
+  }
+
   /* =========== Player =========== */
 
   TEST(Player, ConstructNoPid) {
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <agario/engine/Engine.hpp>
+#include <agario/utils/spatial_index.hpp>
+#include <agario/utils/random.hpp>
+#include <agario/utils/profiler.hpp>
+#include <agario/utils/sweep_and_prune.hpp>
+#include <agario/test/renderable.hpp>
+
+#include <random>
+#include <set>
+
+namespace {
+
+  /* =========== SpatialHash =========== */
+
+  struct Point {
+    float x, y;
+  };
+
+  /* the ids that the hash reports near (x, y), filtered to those within `radius` */
+  std::set<int> query(const agario::SpatialHash &hash, const std::vector<Point> &points,
+                      float x, float y, float radius) {
+    std::set<int> found;
+    hash.for_each_near(x, y, radius, [&](int id) {
+      auto dx = points[id].x - x;
+      auto dy = points[id].y - y;
+      if (dx * dx + dy * dy <= radius * radius)
+        found.insert(id);
+    });
+    return found;
+  }
+
+  /* the ids within `radius` of (x, y), found by brute force */
+  std::set<int> brute_force(const std::vector<Point> &points, float x, float y, float radius) {
+    std::set<int> found;
+    for (int id = 0; id < static_cast<int>(points.size()); id++) {
+      auto dx = points[id].x - x;
+      auto dy = points[id].y - y;
+      if (dx * dx + dy * dy <= radius * radius)
+        found.insert(id);
+    }
+    return found;
+  }
+
+  TEST(Rng, SeedIsDeterministic) {
+    agario::Rng a(1234), b(1234), c(1235);
+    for (int i = 0; i < 1000; i++) {
+      auto x = a();
+      EXPECT_EQ(x, b());
+      EXPECT_NE(x, c());
+    }
+
+    a.seed(99);
+    b.seed(99);
+    EXPECT_EQ(a, b);
+    std::uniform_real_distribution<float> dist(0, 10);
+    for (int i = 0; i < 1000; i++) {
+      float x = dist(a);
+      EXPECT_EQ(x, dist(b));
+      EXPECT_TRUE(0 <= x && x < 10);
+    }
+  }
+
+  TEST(Profiler, Scope) {
+    agario::profile::Profiler profiler;
+    {
+      auto scope = profiler.scope(agario::profile::move);
+      // called directly, since new-expressions may be optimized out
+      void *allocated = ::operator new(sizeof(int));
+      ::operator delete(allocated);
+    }
+    {
+      auto scope = profiler.scope(agario::profile::move);
+    }
+    profiler.count(agario::profile::pellet_candidates, 3);
+    profiler.end_tick(1, 2, 3, 4, 5);
+
+    EXPECT_EQ(profiler.calls(agario::profile::move), 2u);
+#ifdef AGARIO_PROFILE // allocations are only counted in profiled builds
+    EXPECT_EQ(profiler.allocations(agario::profile::move), 1u);
+#endif
+    EXPECT_EQ(profiler.calls(agario::profile::regen), 0u);
+    EXPECT_EQ(profiler.total(agario::profile::pellet_candidates), 3u);
+
+    auto report = profiler.report();
+    EXPECT_EQ(report["move.calls"], 2);
+    EXPECT_EQ(report["viruses"], 5);
+    EXPECT_EQ(report["ticks"], 1);
+  }
+
+  TEST(SpatialHash, Empty) {
+    agario::SpatialHash hash(100, 100, 10);
+    EXPECT_EQ(hash.size(), 0);
+    hash.for_each_in(0, 0, 100, 100, [](int) { FAIL() << "Empty hash visited an entity"; });
+  }
+
+  TEST(SpatialHash, InsertEraseMove) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coord(0, 200);
+    agario::SpatialHash hash(200, 200, 16);
+    std::vector<Point> points;
+
+    for (int round = 0; round < 20; round++) {
+      // insert a batch one at a time
+      for (int i = 0; i < 50; i++) {
+        points.push_back({coord(rng), coord(rng)});
+        hash.insert(points.size() - 1, points.back().x, points.back().y);
+      }
+
+      // swap-and-pop some of them
+      for (int i = 0; i < 20; i++) {
+        int id = std::uniform_int_distribution<int>(0, points.size() - 1)(rng);
+        hash.erase(id);
+        std::swap(points[id], points.back());
+        points.pop_back();
+      }
+
+      // move some of them
+      for (int i = 0; i < 20; i++) {
+        int id = std::uniform_int_distribution<int>(0, points.size() - 1)(rng);
+        points[id] = {coord(rng), coord(rng)};
+        hash.move(id, points[id].x, points[id].y);
+      }
+
+      ASSERT_EQ(hash.size(), points.size());
+      for (int q = 0; q < 10; q++) {
+        float x = coord(rng), y = coord(rng), radius = coord(rng) / 4;
+        ASSERT_EQ(query(hash, points, x, y, radius), brute_force(points, x, y, radius))
+          << "Spatial hash query did not match brute force";
+      }
+    }
+  }
+
+  TEST(SpatialHash, RebuildAndExtend) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(-10, 110); // some out of bounds
+    agario::SpatialHash hash(100, 100, 8);
+    std::vector<Point> points;
+
+    for (int i = 0; i < 500; i++)
+      points.push_back({coord(rng), coord(rng)});
+    hash.rebuild(points);
+    ASSERT_EQ(hash.size(), points.size());
+
+    for (int i = 0; i < 10; i++)
+      points.push_back({coord(rng), coord(rng)});
+    hash.extend(points);
+    ASSERT_EQ(hash.size(), points.size());
+
+    for (int q = 0; q < 50; q++) {
+      float x = coord(rng), y = coord(rng), radius = 15;
+      ASSERT_EQ(query(hash, points, x, y, radius), brute_force(points, x, y, radius));
+    }
+  }
+
+  TEST(SpatialHash, RemoveIfKeepsOrder) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> coord(0, 100);
+    agario::SpatialHash hash(100, 100, 8);
+    std::vector<Point> points;
+
+    for (int round = 0; round < 5; round++) {
+      for (int i = 0; i < 200; i++) {
+        points.push_back({coord(rng), coord(rng)});
+        hash.insert(points.size() - 1, points.back().x, points.back().y);
+      }
+
+      // remove a random third of them, compacting the rest in order
+      std::vector<char> removed(points.size());
+      for (auto &r : removed)
+        r = std::uniform_int_distribution<int>(0, 2)(rng) == 0;
+      hash.remove_if([&](int id) { return removed[id]; });
+      int kept = 0;
+      for (int id = 0; id < static_cast<int>(points.size()); id++)
+        if (!removed[id]) points[kept++] = points[id];
+      points.resize(kept);
+
+      ASSERT_EQ(hash.size(), points.size());
+      for (int q = 0; q < 20; q++) {
+        float x = coord(rng), y = coord(rng), radius = coord(rng) / 4;
+        ASSERT_EQ(query(hash, points, x, y, radius), brute_force(points, x, y, radius))
+          << "Spatial hash query did not match brute force after remove_if";
+      }
+    }
+  }
+
+  /* =========== SweepAndPrune =========== */
+
+  TEST(SweepAndPrune, MatchesBruteForce) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> coord(0, 500);
+    std::uniform_real_distribution<float> size(1, 40);
+    std::vector<std::pair<float, float>> circles; // (x, radius)
+    agario::SweepAndPrune sweep;
+
+    for (int round = 0; round < 10; round++) {
+      // jitter, grow and shrink the set of circles between rounds
+      for (auto &circle : circles)
+        circle.first += coord(rng) / 50 - 5;
+      circles.resize(std::uniform_int_distribution<int>(50, 150)(rng));
+      for (auto &circle : circles)
+        if (circle.second == 0) circle = {coord(rng), size(rng)};
+
+      sweep.clear();
+      for (auto &[x, radius] : circles)
+        sweep.add(x, radius);
+
+      std::set<std::pair<int, int>> found;
+      sweep.for_each_overlap([&](int a, int b) {
+        ASSERT_NE(a, b);
+        ASSERT_TRUE(found.emplace(std::min(a, b), std::max(a, b)).second) << "Pair reported twice";
+      });
+
+      std::set<std::pair<int, int>> expected;
+      int n = static_cast<int>(circles.size());
+      for (int a = 0; a < n; a++)
+        for (int b = a + 1; b < n; b++)
+          if (std::abs(circles[a].first - circles[b].first) <= circles[a].second + circles[b].second)
+            expected.emplace(a, b);
+      ASSERT_EQ(found, expected);
+
+      // the same pairs, in the order of a loop over all pairs
+      std::vector<std::pair<int, int>> in_order;
+      sweep.overlaps_in_order(in_order);
+      std::vector<std::pair<int, int>> expected_order(expected.begin(), expected.end());
+      ASSERT_EQ(in_order, expected_order);
+    }
+  }
+
+  /* the engine must keep the pellet index in sync with the pellets */
+  TEST(SpatialHash, EnginePelletIndex) {
+    using Player = agario::Player<renderable>;
+
+    agario::Engine<renderable> engine(300, 300, 2000, 0);
+    engine.reset();
+    for (int i = 0; i < 10; i++) {
+      auto pid = engine.add_player<Player>("TestPlayer");
+      engine.player(pid).target = engine.random_location();
+    }
+
+    agario::time_delta dt(1.0 / 30);
+    auto &state = engine.get_game_state();
+    for (int t = 0; t < 300; t++) {
+      engine.tick(dt);
+      ASSERT_EQ(state.pellet_index.size(), engine.pellet_count());
+
+      std::vector<int> seen(engine.pellet_count(), 0);
+      state.pellet_index.for_each_in(0, 0, engine.arena_width(), engine.arena_height(),
+                                     [&](int id) { seen[id]++; });
+      for (int count : seen)
+        ASSERT_EQ(count, 1) << "Pellet index out of sync with pellets";
+    }
+  }
+
+}
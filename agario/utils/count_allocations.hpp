@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+ * Replaces the global operator new and delete (plain, aligned and nothrow,
+ * single and array) with versions that count allocations in
+ * agario::profile::allocation_count, so that profiled engines can report the
+ * allocations made in each phase of a tick. Include this in exactly one
+ * translation unit of the program, and only in profiled builds.
+ *
+ * The replacements are kept out of line, so that the compiler never sees a
+ * new-expression paired with the std::free inside of operator delete.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "agario/utils/profiler.hpp"
+
+namespace agario::profile {
+
+  [[gnu::noinline]] inline void *counted_alloc(std::size_t size, std::size_t alignment) {
+    allocation_count++;
+    if (size == 0) size = 1;
+    if (alignment <= alignof(std::max_align_t))
+      return std::malloc(size);
+    // aligned_alloc requires the size to be a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+  }
+
+  [[gnu::noinline]] inline void *counted_alloc_or_throw(std::size_t size, std::size_t alignment) {
+    if (void *ptr = counted_alloc(size, alignment))
+      return ptr;
+    throw std::bad_alloc();
+  }
+
+  [[gnu::noinline]] inline void counted_free(void *ptr) noexcept { std::free(ptr); }
+
+}
+
+void *operator new(std::size_t size) {
+  return agario::profile::counted_alloc_or_throw(size, 0);
+}
+void *operator new[](std::size_t size) {
+  return agario::profile::counted_alloc_or_throw(size, 0);
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return agario::profile::counted_alloc_or_throw(size, static_cast<std::size_t>(alignment));
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return agario::profile::counted_alloc_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return agario::profile::counted_alloc(size, 0);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return agario::profile::counted_alloc(size, 0);
+}
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  return agario::profile::counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  return agario::profile::counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept { agario::profile::counted_free(ptr); }
+void operator delete[](void *ptr) noexcept { agario::profile::counted_free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { agario::profile::counted_free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { agario::profile::counted_free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { agario::profile::counted_free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { agario::profile::counted_free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { agario::profile::counted_free(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { agario::profile::counted_free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { agario::profile::counted_free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { agario::profile::counted_free(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { agario::profile::counted_free(ptr); }
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { agario::profile::counted_free(ptr); }
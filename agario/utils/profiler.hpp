@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace agario::profile {
+
+  /* the phases of a game tick that are timed separately */
+  enum phase : int {
+    bot_actions,        // Player::take_action
+    move,               // moving each player's cells
+    self_collisions,    // pushing apart / merging a player's own cells
+    virus_collisions,   // cells against viruses
+    pellet_collisions,  // cells against pellets
+    food_collisions,    // cells against foods
+    split_and_merge,    // splitting, feeding, recombining and decay
+    remove_entities,    // removing eaten pellets, foods and viruses
+    players_collision,  // cells of different players eating one another
+    move_foods,         // moving foods (and hitting viruses with them)
+    regen,              // regenerating pellets and viruses
+    num_phases
+  };
+
+  constexpr std::array<const char *, num_phases> phase_names = {
+    "bot_actions", "move", "self_collisions", "virus_collisions",
+    "pellet_collisions", "food_collisions", "split_and_merge", "remove_entities",
+    "players_collision", "move_foods", "regen"
+  };
+
+  /* counters accumulated over the profiled ticks */
+  enum counter : int {
+    pellet_candidates,  // pellets returned by the pellet index for some cell
+    virus_candidates,   // viruses returned by the virus index for some cell
+    food_candidates,    // foods returned by the food index for some cell
+    cell_candidates,    // pairs of cells reported by the cell-cell broadphase
+    num_counters
+  };
+
+  constexpr std::array<const char *, num_counters> counter_names = {
+    "pellet_candidates", "virus_candidates", "food_candidates", "cell_candidates"
+  };
+
+  /**
+   * Number of heap allocations made by the calling thread. Only counts
+   * anything in programs that include "agario/utils/count_allocations.hpp"
+   * (in exactly one translation unit), otherwise it stays at zero.
+   */
+  inline thread_local std::uint64_t allocation_count = 0;
+
+  /**
+   * Accumulates the time spent in, and allocations made during, each phase
+   * of the game tick, along with counters of collision candidates and the
+   * number of entities at the end of the last tick. Owned by an Engine
+   * that was instantiated with profiling enabled.
+   */
+  class Profiler {
+    using clock = std::chrono::steady_clock;
+
+  public:
+    /* times the enclosing block as (part of) a phase */
+    class Scope {
+    public:
+      Scope(Profiler &profiler, phase p) :
+        profiler_(profiler), phase_(p),
+        start_(clock::now()), start_allocations_(allocation_count) { }
+
+      ~Scope() {
+        std::chrono::duration<double> elapsed = clock::now() - start_;
+        profiler_.seconds_[phase_] += elapsed.count();
+        profiler_.calls_[phase_]++;
+        profiler_.allocations_[phase_] += allocation_count - start_allocations_;
+      }
+
+      Scope(const Scope &) = delete;
+      Scope &operator=(const Scope &) = delete;
+
+    private:
+      Profiler &profiler_;
+      phase phase_;
+      clock::time_point start_;
+      std::uint64_t start_allocations_;
+    };
+
+    Scope scope(phase p) { return Scope(*this, p); }
+
+    void count(counter c, std::uint64_t n = 1) { counters_[c] += n; }
+
+    /* records the end of a tick, with the number of entities in the game */
+    void end_tick(int players, int cells, int pellets, int foods, int viruses) {
+      ticks_++;
+      players_ = players;
+      cells_ = cells;
+      pellets_ = pellets;
+      foods_ = foods;
+      viruses_ = viruses;
+    }
+
+    [[nodiscard]] std::uint64_t ticks() const { return ticks_; }
+    [[nodiscard]] double seconds(phase p) const { return seconds_[p]; }
+    [[nodiscard]] std::uint64_t calls(phase p) const { return calls_[p]; }
+    [[nodiscard]] std::uint64_t allocations(phase p) const { return allocations_[p]; }
+    [[nodiscard]] std::uint64_t total(counter c) const { return counters_[c]; }
+
+    /**
+     * Flat summary of everything recorded since the last reset: for each phase
+     * "<phase>.seconds", "<phase>.calls" and "<phase>.allocations", the
+     * counters, "ticks", and the entity counts at the end of the last tick.
+     */
+    [[nodiscard]] std::map<std::string, double> report() const {
+      std::map<std::string, double> summary;
+      for (int p = 0; p < num_phases; p++) {
+        std::string name = phase_names[p];
+        summary[name + ".seconds"] = seconds_[p];
+        summary[name + ".calls"] = static_cast<double>(calls_[p]);
+        summary[name + ".allocations"] = static_cast<double>(allocations_[p]);
+      }
+      for (int c = 0; c < num_counters; c++)
+        summary[counter_names[c]] = static_cast<double>(counters_[c]);
+
+      summary["ticks"] = static_cast<double>(ticks_);
+      summary["players"] = players_;
+      summary["cells"] = cells_;
+      summary["pellets"] = pellets_;
+      summary["foods"] = foods_;
+      summary["viruses"] = viruses_;
+      return summary;
+    }
+
+    void reset() { *this = Profiler(); }
+
+    /* adds the phase times and counters recorded by `other`, e.g. by another thread during a tick */
+    void merge(const Profiler &other) {
+      for (int p = 0; p < num_phases; p++) {
+        seconds_[p] += other.seconds_[p];
+        calls_[p] += other.calls_[p];
+        allocations_[p] += other.allocations_[p];
+      }
+      for (int c = 0; c < num_counters; c++)
+        counters_[c] += other.counters_[c];
+    }
+
+  private:
+    std::array<double, num_phases> seconds_ {};
+    std::array<std::uint64_t, num_phases> calls_ {};
+    std::array<std::uint64_t, num_phases> allocations_ {};
+    std::array<std::uint64_t, num_counters> counters_ {};
+
+    std::uint64_t ticks_ = 0;
+    int players_ = 0, cells_ = 0, pellets_ = 0, foods_ = 0, viruses_ = 0;
+  };
+
+  /* stands in for Profiler (and its Scope) in engines built without profiling */
+  class NoProfiler {
+  public:
+    struct Scope {
+      ~Scope() { } // non-trivial, so that unused scopes don't warn
+    };
+    Scope scope(phase) { return {}; }
+    void count(counter, std::uint64_t = 1) { }
+    void end_tick(int, int, int, int, int) { }
+    [[nodiscard]] std::map<std::string, double> report() const { return {}; }
+    void reset() { }
+    void merge(const NoProfiler &) { }
+  };
+
+}
@@ -1,5 +1,11 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <random>
 #include <type_traits>
+#include <utility>
 
 #include "agario/core/num_wrapper.hpp"
 
@@ -18,3 +24,106 @@ using uniform_distribution =
       void
     >::type
   >::type;
+
+namespace agario {
+
+  /**
+   * xoshiro256++ (Blackman & Vigna): a small and fast generator with 256 bits
+   * of state. The state is expanded from a single 64-bit seed with splitmix64,
+   * so equal seeds always produce equal sequences. Satisfies the standard
+   * UniformRandomBitGenerator requirements, so it works with <random>'s
+   * distributions.
+   */
+  class Xoshiro256pp {
+  public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256pp(std::uint64_t seed = 0) { this->seed(seed); }
+
+    void seed(std::uint64_t seed) {
+      for (auto &word : s_)
+        word = _splitmix64(seed);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+      const std::uint64_t result = _rotl(s_[0] + s_[3], 23) + s_[0];
+      const std::uint64_t t = s_[1] << 17;
+
+      s_[2] ^= s_[0];
+      s_[3] ^= s_[1];
+      s_[1] ^= s_[2];
+      s_[0] ^= s_[3];
+      s_[2] ^= t;
+      s_[3] = _rotl(s_[3], 45);
+      return result;
+    }
+
+    /* the full generator state, e.g. to record and later restore it exactly */
+    [[nodiscard]] const std::array<std::uint64_t, 4> &state() const { return s_; }
+    void set_state(const std::array<std::uint64_t, 4> &state) { s_ = state; }
+
+    bool operator==(const Xoshiro256pp &other) const { return s_ == other.s_; }
+    bool operator!=(const Xoshiro256pp &other) const { return s_ != other.s_; }
+
+  private:
+    std::array<std::uint64_t, 4> s_;
+
+    static std::uint64_t _rotl(std::uint64_t x, int k) {
+      return (x << k) | (x >> (64 - k));
+    }
+
+    static std::uint64_t _splitmix64(std::uint64_t &x) {
+      std::uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      return z ^ (z >> 31);
+    }
+  };
+
+  /**
+   * The R2 low-discrepancy sequence (Roberts, 2018): the additive recurrence
+   * p_{n+1} = frac(p_n + (1/g, 1/g^2)), with g the plastic number. Its points
+   * cover the unit square more evenly than independent uniform draws do, and
+   * each costs two additions rather than two calls to a distribution.
+   */
+  class R2Sequence {
+  public:
+    explicit R2Sequence(double x = 0.5, double y = 0.5) : x_(x), y_(y) { }
+
+    /* starts the sequence from a point in [0, 1)^2 taken from the bits of `seed` */
+    void seed(std::uint64_t seed) {
+      x_ = static_cast<double>(seed >> 32) / 4294967296.0;
+      y_ = static_cast<double>(seed & 0xffffffffull) / 4294967296.0;
+    }
+
+    /* the next point of the sequence, in [0, 1)^2 */
+    std::pair<double, double> operator()() {
+      x_ += a1;
+      if (x_ >= 1) x_ -= 1;
+      y_ += a2;
+      if (y_ >= 1) y_ -= 1;
+      return {x_, y_};
+    }
+
+    bool operator==(const R2Sequence &other) const { return x_ == other.x_ && y_ == other.y_; }
+    bool operator!=(const R2Sequence &other) const { return !(*this == other); }
+
+  private:
+    static constexpr double a1 = 0.75487766624669276005; // 1 / g
+    static constexpr double a2 = 0.56984029099805326591; // 1 / g^2
+    double x_, y_;
+  };
+
+  /* the generator that each game owns, and that all of its randomness comes from */
+  using Rng = Xoshiro256pp;
+
+  /* generator owned by the calling thread, for cosmetic randomness (i.e. colors) outside of any game */
+  inline Rng &thread_rng() {
+    thread_local Rng rng(std::random_device{}());
+    return rng;
+  }
+
+}
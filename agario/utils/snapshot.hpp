@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Binary snapshots of the game state, the fast alternative to the JSON
+ * export of save_env_state. A snapshot is a little-endian sequence of
+ * fixed-size records and contiguous arrays, every one of them a multiple of
+ * 4 bytes long so that the arrays of a memory-mapped snapshot are aligned
+ * and can be bulk-loaded straight out of the mapping:
+ *
+ *   Header
+ *   u32 num_players, then for each player:
+ *     PlayerRecord, char name[name_length] (zero padded to a multiple of 4),
+ *     CellRecord cells[num_cells], i32 virus_eaten_ticks[num_virus_eaten_ticks]
+ *   u32 num_pellets, f32 x[num_pellets], f32 y[num_pellets]
+ *   u32 num_viruses, f32 x[], f32 y[], f32 velocity_x[], f32 velocity_y[], u32 mass[]
+ *   u32 num_foods,   f32 x[], f32 y[], f32 velocity_x[], f32 velocity_y[]
+ *
+ * A snapshot holds the same state as the JSON export does, and is loaded
+ * the same way (see Engine::load_env_state).
+ */
+namespace agario::snapshot {
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "snapshots are read and written in the host byte order, which must be little-endian"
+#endif
+
+  constexpr char magic[4] = {'A', 'G', 'S', 'N'};
+  constexpr std::uint32_t version = 1;
+
+  /* the environment that the snapshot was saved from */
+  struct Header {
+    char magic[4];
+    std::uint32_t version;
+    std::int32_t num_agents;
+    std::int32_t ticks_per_step;
+    std::int32_t arena_size;
+    std::int32_t num_bots;
+    std::int32_t reward_type;
+    std::int32_t seed;
+    std::int32_t c_death;
+    std::int32_t mode_number;
+    std::uint32_t pellet_regen;
+    std::uint32_t reserved;
+  };
+
+  struct PlayerRecord {
+    std::uint32_t pid;
+    std::uint32_t name_length;
+    float target_x, target_y;
+    std::uint32_t is_bot;
+    std::uint32_t dead;
+    std::uint32_t split_cooldown;
+    std::uint32_t feed_cooldown;
+    float anti_team_decay;
+    std::int32_t elapsed_ticks;
+    std::int32_t last_decay_tick;
+    std::int32_t food_eaten;
+    std::uint32_t highest_mass;
+    std::int32_t cells_eaten;
+    std::int32_t viruses_eaten;
+    std::int32_t top_position;
+    std::uint32_t num_cells;
+    std::uint32_t num_virus_eaten_ticks;
+  };
+
+  struct CellRecord {
+    std::int32_t id;
+    float x, y;
+    std::uint32_t mass;
+    float velocity_x, velocity_y;
+  };
+
+  static_assert(sizeof(Header) % 4 == 0 && sizeof(PlayerRecord) % 4 == 0 && sizeof(CellRecord) % 4 == 0);
+
+  /* whether `filename` starts with the snapshot magic (rather than being JSON) */
+  inline bool is_snapshot(const std::string &filename) {
+    std::ifstream in(filename, std::ios::binary);
+    char start[sizeof(magic)] = {};
+    in.read(start, sizeof(start));
+    return in && std::memcmp(start, magic, sizeof(magic)) == 0;
+  }
+
+  class Writer {
+  public:
+    explicit Writer(const std::string &filename) : out_(filename, std::ios::binary) {
+      if (!out_.is_open())
+        throw std::runtime_error("Failed to open " + filename + " for writing");
+    }
+
+    template<typename T>
+    void write(const T &value) {
+      static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % 4 == 0);
+      out_.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    void write_array(const T *values, std::size_t n) {
+      static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % 4 == 0);
+      out_.write(reinterpret_cast<const char *>(values), n * sizeof(T));
+    }
+
+    /* writes the characters of `s`, zero padded to a multiple of 4 bytes */
+    void write_string(const std::string &s) {
+      out_.write(s.data(), s.size());
+      static const char padding[4] = {};
+      out_.write(padding, _padded(s.size()) - s.size());
+    }
+
+    /* flushes the snapshot to disk, throwing if any of it failed to be written */
+    void close() {
+      out_.close();
+      if (!out_)
+        throw std::runtime_error("Failed to write snapshot");
+    }
+
+  private:
+    std::ofstream out_;
+    friend class Reader;
+
+    static std::size_t _padded(std::size_t n) { return (n + 3) & ~static_cast<std::size_t>(3); }
+  };
+
+  /**
+   * Reads a snapshot through a read-only memory mapping of it. Arrays are
+   * returned as pointers into the mapping (which stays valid for the
+   * lifetime of the Reader), so loading them is a bulk copy.
+   */
+  class Reader {
+  public:
+    explicit Reader(const std::string &filename) {
+      int fd = ::open(filename.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw std::runtime_error("Failed to open " + filename + " for reading");
+
+      struct stat st{};
+      if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        size_ = static_cast<std::size_t>(st.st_size);
+        void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) data_ = static_cast<const char *>(mapping);
+      }
+      ::close(fd);
+
+      if (data_ == nullptr)
+        throw std::runtime_error("Failed to map " + filename);
+
+      auto header = read<Header>();
+      if (std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+        throw std::runtime_error(filename + " is not a snapshot");
+      if (header.version != version)
+        throw std::runtime_error(filename + " is a version " + std::to_string(header.version)
+                                 + " snapshot, expected version " + std::to_string(version));
+      header_ = header;
+    }
+
+    ~Reader() {
+      if (data_ != nullptr)
+        ::munmap(const_cast<char *>(data_), size_);
+    }
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    [[nodiscard]] const Header &header() const { return header_; }
+
+    template<typename T>
+    T read() {
+      T value;
+      std::memcpy(&value, _take(sizeof(T)), sizeof(T));
+      return value;
+    }
+
+    /* the next `n` values, in place in the mapping */
+    template<typename T>
+    const T *read_array(std::size_t n) {
+      static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 4);
+      return reinterpret_cast<const T *>(_take(n * sizeof(T)));
+    }
+
+    std::string read_string(std::size_t length) {
+      const char *chars = _take(Writer::_padded(length));
+      return std::string(chars, length);
+    }
+
+  private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t offset_ = 0;
+    Header header_ = {};
+
+    const char *_take(std::size_t bytes) {
+      if (bytes > size_ - offset_)
+        throw std::runtime_error("Snapshot is truncated");
+      const char *start = data_ + offset_;
+      offset_ += bytes;
+      return start;
+    }
+  };
+
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+namespace agario {
+
+  /**
+   * Uniform-grid spatial hash over entity indices that persists between
+   * game ticks. Buckets are stored in a flat, CSR-style layout: bucket `b`
+   * owns the slots [start_[b], start_[b + 1]) of `items_`, the first
+   * `count_[b]` of which are in use. The spare slots at the end of each
+   * bucket allow entities to be inserted, moved and removed in place; the
+   * layout is only rebuilt when a bucket runs out of room.
+   *
+   * Entity ids are the indices of the entities in the container that holds
+   * them, and `erase` mirrors that container's swap-and-pop removal so that
+   * the two can be kept in lock step.
+   */
+  class SpatialHash {
+  public:
+    SpatialHash() : SpatialHash(1, 1, 1) { }
+
+    SpatialHash(float width, float height, float bucket_size) {
+      configure(width, height, bucket_size);
+    }
+
+    /* sets the area covered by the hash and empties it */
+    void configure(float width, float height, float bucket_size) {
+      bucket_size_ = bucket_size;
+      cols_ = std::max(1, static_cast<int>(std::ceil(width / bucket_size)));
+      rows_ = std::max(1, static_cast<int>(std::ceil(height / bucket_size)));
+      clear();
+    }
+
+    void clear() {
+      start_.assign(num_buckets() + 1, 0);
+      count_.assign(num_buckets(), 0);
+      items_.clear();
+      slot_.clear();
+      bucket_.clear();
+    }
+
+    /* the number of entities in the hash */
+    [[nodiscard]] int size() const { return static_cast<int>(slot_.size()); }
+
+    [[nodiscard]] int num_buckets() const { return cols_ * rows_; }
+
+    /* indexes all of `entities` from scratch, with ids 0..entities.size()-1 */
+    template<typename Entities>
+    void rebuild(const Entities &entities) {
+      int n = static_cast<int>(entities.size());
+      std::fill(count_.begin(), count_.end(), 0);
+      bucket_.resize(n);
+      slot_.resize(n);
+      for (int id = 0; id < n; id++) {
+        bucket_[id] = bucket_index(entities[id].x, entities[id].y);
+        count_[bucket_[id]]++;
+      }
+      _layout(-1);
+      std::fill(count_.begin(), count_.end(), 0);
+      for (int id = 0; id < n; id++) {
+        int b = bucket_[id];
+        slot_[id] = start_[b] + count_[b]++;
+        items_[slot_[id]] = id;
+      }
+    }
+
+    /**
+     * Indexes the entities with ids size()..entities.size()-1 that were
+     * appended to `entities` since it was last synchronized with the hash.
+     * Large batches are indexed with a single rebuild.
+     */
+    template<typename Entities>
+    void extend(const Entities &entities) {
+      int first = size();
+      int n = static_cast<int>(entities.size());
+      if (4 * (n - first) > first + num_buckets()) {
+        rebuild(entities);
+        return;
+      }
+      for (int id = first; id < n; id++)
+        insert(id, entities[id].x, entities[id].y);
+    }
+
+    /* adds the entity `id` (which must equal size()) located at (x, y) */
+    void insert(int id, float x, float y) {
+      assert(id == size());
+      bucket_.push_back(-1);
+      slot_.push_back(-1);
+      _link(id, bucket_index(x, y));
+    }
+
+    /* removes entity `id`, renaming the last entity to `id` (swap-and-pop) */
+    void erase(int id) {
+      _unlink(id);
+      int last = size() - 1;
+      if (id != last) {
+        bucket_[id] = bucket_[last];
+        slot_[id] = slot_[last];
+        items_[slot_[id]] = id;
+      }
+      bucket_.pop_back();
+      slot_.pop_back();
+    }
+
+    /**
+     * Removes every entity `id` for which `pred(id)`, renumbering the rest in
+     * order to mirror their container's (stable) remove_if. `pred` is called
+     * twice for each entity and must give the same answer both times.
+     */
+    template<typename Pred>
+    void remove_if(Pred &&pred) {
+      int n = size();
+      for (int id = 0; id < n; id++)
+        if (pred(id)) _unlink(id);
+
+      int kept = 0;
+      for (int id = 0; id < n; id++) {
+        if (pred(id)) continue;
+        if (kept != id) {
+          bucket_[kept] = bucket_[id];
+          slot_[kept] = slot_[id];
+          items_[slot_[kept]] = kept;
+        }
+        kept++;
+      }
+      bucket_.resize(kept);
+      slot_.resize(kept);
+    }
+
+    /* updates the location of entity `id` to (x, y) */
+    void move(int id, float x, float y) {
+      int b = bucket_index(x, y);
+      if (b == bucket_[id]) return;
+      _unlink(id);
+      _link(id, b);
+    }
+
+    /**
+     * Calls `f(id)` for every entity in a bucket overlapping the axis-aligned
+     * box [min_x, max_x] x [min_y, max_y]. Entities outside of the box but in
+     * an overlapping bucket are visited as well, so callers must still do their
+     * own exact test. The hash must not be modified from within `f`.
+     */
+    template<typename F>
+    void for_each_in(float min_x, float min_y, float max_x, float max_y, F &&f) const {
+      int c0 = _col(min_x), c1 = _col(max_x);
+      int r0 = _row(min_y), r1 = _row(max_y);
+      for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+          int b = r * cols_ + c;
+          const int *it = items_.data() + start_[b];
+          const int *end = it + count_[b];
+          for (; it != end; ++it)
+            f(*it);
+        }
+      }
+    }
+
+    /* calls `f(id)` for the entities near the circle at (x, y) with radius `radius` */
+    template<typename F>
+    void for_each_near(float x, float y, float radius, F &&f) const {
+      for_each_in(x - radius, y - radius, x + radius, y + radius, std::forward<F>(f));
+    }
+
+    [[nodiscard]] int bucket_index(float x, float y) const {
+      return _row(y) * cols_ + _col(x);
+    }
+
+  private:
+    float bucket_size_;
+    int cols_;
+    int rows_;
+
+    std::vector<int> start_;  // CSR offsets of each bucket into `items_`
+    std::vector<int> count_;  // number of used slots in each bucket
+    std::vector<int> items_;  // entity ids, grouped by bucket
+    std::vector<int> slot_;   // entity id -> slot in `items_`
+    std::vector<int> bucket_; // entity id -> bucket
+
+    [[nodiscard]] int _col(float x) const {
+      return std::clamp(static_cast<int>(x / bucket_size_), 0, cols_ - 1);
+    }
+
+    [[nodiscard]] int _row(float y) const {
+      return std::clamp(static_cast<int>(y / bucket_size_), 0, rows_ - 1);
+    }
+
+    [[nodiscard]] int _capacity(int b) const { return start_[b + 1] - start_[b]; }
+
+    void _link(int id, int b) {
+      if (count_[b] == _capacity(b))
+        _relayout(b);
+      int s = start_[b] + count_[b]++;
+      items_[s] = id;
+      slot_[id] = s;
+      bucket_[id] = b;
+    }
+
+    /* removes `id` from its bucket by moving the bucket's last entity into its slot */
+    void _unlink(int id) {
+      int b = bucket_[id];
+      int last_slot = start_[b] + --count_[b];
+      int s = slot_[id];
+      items_[s] = items_[last_slot];
+      slot_[items_[s]] = s;
+    }
+
+    /**
+     * Computes bucket offsets from `count_`, leaving each bucket some spare
+     * slots proportional to its occupancy. `grow` is a bucket that needs at
+     * least one more slot, or -1.
+     */
+    void _layout(int grow) {
+      int average = size() / num_buckets();
+      int offset = 0;
+      for (int b = 0; b < num_buckets(); b++) {
+        start_[b] = offset;
+        offset += count_[b] + std::max(count_[b] / 2, average) + 1 + (b == grow);
+      }
+      start_[num_buckets()] = offset;
+      items_.assign(offset, -1);
+    }
+
+    /* re-lays out the existing entities with fresh spare room in each bucket */
+    void _relayout(int grow) {
+      std::vector<int> old_items(std::move(items_));
+      std::vector<int> old_start(start_);
+      _layout(grow);
+      for (int b = 0; b < num_buckets(); b++) {
+        for (int i = 0; i < count_[b]; i++) {
+          int id = old_items[old_start[b] + i];
+          items_[start_[b] + i] = id;
+          slot_[id] = start_[b] + i;
+        }
+      }
+    }
+  };
+
+}
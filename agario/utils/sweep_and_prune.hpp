@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+namespace agario {
+
+  /**
+   * Sort-and-sweep broadphase over circles, along the x axis. Circles are
+   * added each tick with ids 0..size()-1 and `for_each_overlap` reports
+   * every pair whose x-extents overlap. The sort order is kept between
+   * ticks, so since entities only move a little from one tick to the next
+   * re-sorting is close to linear, and none of the buffers are reallocated
+   * once they have grown to the number of circles in the game.
+   */
+  class SweepAndPrune {
+  public:
+    void clear() {
+      min_x_.clear();
+      max_x_.clear();
+    }
+
+    /* the number of circles added since the last call to `clear` */
+    [[nodiscard]] int size() const { return static_cast<int>(min_x_.size()); }
+
+    /* adds a circle with id size() centered at `x` with radius `radius` */
+    void add(float x, float radius) {
+      min_x_.push_back(x - radius);
+      max_x_.push_back(x + radius);
+    }
+
+    /**
+     * Calls `f(a, b)` (with a != b) once for each pair of circles whose
+     * x-extents overlap. Callers must do their own exact test.
+     */
+    template<typename F>
+    void for_each_overlap(F &&f) {
+      _sort();
+      int n = size();
+      for (int i = 0; i < n; i++) {
+        int a = order_[i];
+        for (int j = i + 1; j < n && min_x_[order_[j]] <= max_x_[a]; j++)
+          f(a, order_[j]);
+      }
+    }
+
+    /**
+     * Fills `pairs` with the pairs (a, b), a < b, of circles whose x-extents
+     * overlap, ordered by a and then by b: the order in which a loop over
+     * all pairs would visit them. Sorted in linear time.
+     */
+    void overlaps_in_order(std::vector<std::pair<int, int>> &pairs) {
+      pairs.clear();
+      for_each_overlap([&pairs](int a, int b) { pairs.emplace_back(std::min(a, b), std::max(a, b)); });
+
+      // stable counting sorts by the second id and then by the first
+      _sort_pairs(pairs, [](const std::pair<int, int> &pair) { return pair.second; });
+      _sort_pairs(pairs, [](const std::pair<int, int> &pair) { return pair.first; });
+    }
+
+  private:
+    std::vector<float> min_x_;
+    std::vector<float> max_x_;
+    std::vector<int> order_;  // ids sorted by min_x_, kept from the previous tick
+
+    std::vector<int> counts_;                  // scratch for _sort_pairs
+    std::vector<std::pair<int, int>> sorted_;  // scratch for _sort_pairs
+
+    /* stable counting sort of `pairs` by the id `key(pair)` */
+    template<typename Key>
+    void _sort_pairs(std::vector<std::pair<int, int>> &pairs, Key key) {
+      counts_.assign(size() + 1, 0);
+      for (auto &pair : pairs)
+        counts_[key(pair) + 1]++;
+      for (int id = 1; id <= size(); id++)
+        counts_[id] += counts_[id - 1];
+
+      sorted_.resize(pairs.size());
+      for (auto &pair : pairs)
+        sorted_[counts_[key(pair)]++] = pair;
+      pairs.swap(sorted_);
+    }
+
+    /* brings `order_` up to date with the current ids and sorts it by min_x_ */
+    void _sort() {
+      int n = size();
+      int prev = static_cast<int>(order_.size());
+      if (prev > n)
+        order_.erase(std::remove_if(order_.begin(), order_.end(), [n](int id) { return id >= n; }),
+                     order_.end());
+      for (int id = prev; id < n; id++)
+        order_.push_back(id);
+
+      // insertion sort: close to linear when the order is nearly unchanged
+      for (int i = 1; i < n; i++) {
+        int id = order_[i];
+        float key = min_x_[id];
+        int j = i - 1;
+        for (; j >= 0 && min_x_[order_[j]] > key; j--)
+          order_[j + 1] = order_[j];
+        order_[j + 1] = id;
+      }
+    }
+  };
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace agario {
+
+  /**
+   * A fixed set of threads for running parallel loops. `run(n, f)` calls
+   * `f(i, worker)` for every i in [0, n) and returns once all calls are done,
+   * with the calling thread working as worker 0 alongside the pool's threads
+   * (workers 1 to num_threads - 1). Indices are claimed one at a time from a
+   * shared counter, so a worker that finishes early takes over the remaining
+   * indices rather than waiting on a fixed share, and `worker` identifies
+   * the thread so that `f` can write to per-thread buffers without locking.
+   */
+  class WorkPool {
+  public:
+    explicit WorkPool(int num_threads) : num_threads_(std::max(num_threads, 1)) {
+      for (int w = 1; w < num_threads_; w++)
+        threads_.emplace_back([this, w] { _work(w); });
+    }
+
+    ~WorkPool() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exiting_ = true;
+      }
+      start_.notify_all();
+      for (auto &thread : threads_)
+        thread.join();
+    }
+
+    WorkPool(const WorkPool &) = delete;
+    WorkPool &operator=(const WorkPool &) = delete;
+
+    [[nodiscard]] int num_threads() const { return num_threads_; }
+
+    /* calls f(i, worker) for i in [0, n), rethrowing the first exception that any call threw */
+    void run(int n, const std::function<void(int, int)> &f) {
+      if (n <= 0) return;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &f;
+        size_ = n;
+        next_.store(0);
+        busy_ = num_threads_ - 1;
+        error_ = nullptr;
+        generation_++;
+      }
+      start_.notify_all();
+
+      _claim(0);
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_.wait(lock, [this] { return busy_ == 0; });
+      task_ = nullptr;
+      if (error_) std::rethrow_exception(error_);
+    }
+
+  private:
+    int num_threads_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    const std::function<void(int, int)> *task_ = nullptr;
+    int size_ = 0;
+    std::atomic<int> next_ {0};
+    int busy_ = 0;                // pool threads still working on the current run
+    unsigned long generation_ = 0; // number of runs started, to wake the pool for each one
+    bool exiting_ = false;
+    std::exception_ptr error_;
+
+    /* runs indices of the current task until there are none left */
+    void _claim(int worker) {
+      for (int i = next_.fetch_add(1); i < size_; i = next_.fetch_add(1)) {
+        try {
+          (*task_)(i, worker);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (!error_) error_ = std::current_exception();
+        }
+      }
+    }
+
+    void _work(int worker) {
+      unsigned long seen = 0;
+      while (true) {
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          start_.wait(lock, [&] { return exiting_ || generation_ != seen; });
+          if (exiting_) return;
+          seen = generation_;
+        }
+
+        _claim(worker);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--busy_ == 0)
+          done_.notify_one();
+      }
+    }
+  };
+
+}
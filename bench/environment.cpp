@@ -0,0 +1,240 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+
+#include <agario/engine/Engine.hpp>
+#include <agario/bots/bots.hpp>
+#include <environment/envs/GridEnvironment.hpp>
+#include <environment/envs/GoBiggerEnvironment.hpp>
+#include <environment/envs/ReplayEnvironment.hpp>
+
+using Engine = agario::Engine<false>;
+using GridEnvironment = agario::env::GridEnvironment<int, false>;
+using GridObservation = agario::env::GridObservation<int, false>;
+using GoBiggerObservation = agario::env::GoBiggerObservation<false>;
+
+using HungryBot = agario::bot::HungryBot<false>;
+using HungryShyBot = agario::bot::HungryShyBot<false>;
+using AggressiveBot = agario::bot::AggressiveBot<false>;
+using AggressiveShyBot = agario::bot::AggressiveShyBot<false>;
+
+static const agario::time_delta dt(1.0 / 60);
+
+/**
+ * Plays a game with `num_bots` bots of mixed types for ten seconds of
+ * game time, so that there are split cells, foods and eaten pellets to
+ * observe. Returns the pid of the first bot.
+ */
+static agario::pid play_game(Engine &engine, int num_bots) {
+  engine.seed(0);
+  engine.reset();
+  auto observer = engine.add_player<HungryBot>();
+  for (int i = 1; i < num_bots; i++) {
+    switch (i % 4) {
+      case 0: engine.add_player<HungryBot>(); break;
+      case 1: engine.add_player<HungryShyBot>(); break;
+      case 2: engine.add_player<AggressiveBot>(); break;
+      case 3: engine.add_player<AggressiveShyBot>(); break;
+    }
+  }
+
+  for (int t = 0; t < 600; t++)
+    engine.tick(dt);
+  return observer;
+}
+
+/* adds one frame to a grid observation of a populated game, for a range of grid sizes */
+static void GridAddFrame(benchmark::State& state) {
+  int grid_size = state.range(0);
+  Engine engine(1000, 1000, 1000, 10);
+  auto &player = engine.player(play_game(engine, 10));
+
+  GridObservation observation(1, grid_size, true, true, true, true);
+  for (auto _ : state) {
+    observation.clear_data();
+    observation.add_frame(player, engine.game_state(), 0);
+    benchmark::DoNotOptimize(observation.data());
+  }
+}
+BENCHMARK(GridAddFrame)->RangeMultiplier(2)->Range(32, 256);
+
+/* adds one frame to a 128x128 grid observation of a large arena, with a varying number of pellets */
+static void GridAddFrameArena(benchmark::State& state) {
+  int num_pellets = state.range(0);
+  Engine engine(5000, 5000, num_pellets, 100);
+  auto &player = engine.player(play_game(engine, 10));
+
+  GridObservation observation(1, 128, true, true, true, true);
+  for (auto _ : state) {
+    observation.clear_data();
+    observation.add_frame(player, engine.game_state(), 0);
+    benchmark::DoNotOptimize(observation.data());
+  }
+}
+BENCHMARK(GridAddFrameArena)->ArgName("pellets")->Arg(1000)->Arg(10000)->Arg(50000);
+
+/* adds one frame to a 128x128 grid observation of each (compact) dtype */
+template<typename T>
+static void GridAddFrameDType(benchmark::State& state) {
+  Engine engine(1000, 1000, 1000, 10);
+  auto &player = engine.player(play_game(engine, 10));
+
+  agario::env::GridObservation<T, false> observation(1, 128, true, true, true, true);
+  for (auto _ : state) {
+    observation.clear_data();
+    observation.add_frame(player, engine.game_state(), 0);
+    benchmark::DoNotOptimize(observation.data());
+  }
+  state.counters["bytes"] = observation.length() * sizeof(T);
+}
+BENCHMARK_TEMPLATE(GridAddFrameDType, int);
+BENCHMARK_TEMPLATE(GridAddFrameDType, std::uint16_t);
+BENCHMARK_TEMPLATE(GridAddFrameDType, std::uint8_t);
+BENCHMARK_TEMPLATE(GridAddFrameDType, agario::env::float16);
+
+/* adds one frame to a GoBigger observation, which stores the state of every player in the game */
+static void GoBiggerAddFrame(benchmark::State& state) {
+  int num_bots = state.range(0);
+  Engine engine(1000, 1000, 1000, 10);
+  auto &player = engine.player(play_game(engine, num_bots));
+
+  GoBiggerObservation observation(1000, 1000, 3600, 0, num_bots);
+  observation.configure(1, 128, true, true, true, true);
+  for (auto _ : state) {
+    observation.clear();
+    observation.add_frame(player, engine.game_state(), 0);
+  }
+}
+BENCHMARK(GoBiggerAddFrame)->Arg(1)->Arg(10)->Arg(30);
+
+/* steps a single agent grid environment with 10 bots, in every game mode and at two grid sizes */
+static void EnvStep(benchmark::State& state) {
+  int mode = state.range(0);
+  int grid_size = state.range(1);
+  GridEnvironment env(1, 4, 1000, true, 1000, 10, 10, 0, 0, mode);
+  env.configure_observation(1, grid_size, true, true, true, true);
+  env.seed(0);
+  env.reset();
+
+  std::vector<agario::env::Action> actions = {agario::env::Action(0.5, -0.5, agario::action::none)};
+  for (auto _ : state) {
+    env.take_actions(actions);
+    env.step();
+
+    if (env.dones().front()) {
+      state.PauseTiming();
+      env.reset();
+      state.ResumeTiming();
+    }
+  }
+}
+BENCHMARK(EnvStep)
+  ->ArgNames({"mode", "grid"})
+  ->ArgsProduct({benchmark::CreateDenseRange(0, 10, 1), {32, 128}});
+
+/* steps a grid environment that stacks the frames of the last `frames` steps */
+static void EnvStepFrameStack(benchmark::State& state) {
+  int num_frames = state.range(0);
+  GridEnvironment env(1, 4, 1000, true, 1000, 10, 10);
+  env.configure_observation(num_frames, 128, true, true, true, true);
+  env.seed(0);
+  env.reset();
+
+  std::vector<agario::env::Action> actions = {agario::env::Action(0.5, -0.5, agario::action::none)};
+  for (auto _ : state) {
+    env.take_actions(actions);
+    env.step();
+  }
+}
+BENCHMARK(EnvStepFrameStack)->ArgName("frames")->Arg(1)->Arg(4)->Arg(8);
+
+/* forks a grid environment after 150 steps into a new environment (clone=1) or into an existing one (clone=0) */
+static void EnvFork(benchmark::State& state) {
+  GridEnvironment env(1, 4, 1000, true, state.range(0), 10, 10);
+  env.configure_observation(1, 128, true, true, true, true);
+  env.seed(0);
+  env.reset();
+  for (int i = 0; i < 150; i++)
+    env.step();
+
+  if (state.range(1)) {
+    for (auto _ : state)
+      benchmark::DoNotOptimize(env.clone());
+  } else {
+    auto fork = env.clone();
+    for (auto _ : state)
+      fork->copy_state_from(env);
+  }
+}
+BENCHMARK(EnvFork)->ArgNames({"pellets", "clone"})->ArgsProduct({{1000, 10000}, {1, 0}});
+
+/* a temporary state file, which gets a JSON export when `json` and a binary snapshot otherwise */
+static std::string state_file(bool json) {
+  auto name = json ? "agarcl-bench-state.json" : "agarcl-bench-state.bin";
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+/* saves the state of a grid environment after 150 steps to a JSON (json=1) or binary (json=0) file */
+static void SaveEnvState(benchmark::State& state) {
+  GridEnvironment env(1, 4, 1000, true, state.range(0), 10, 10);
+  env.configure_observation(1, 128, true, true, true, true);
+  env.seed(0);
+  env.reset();
+  for (int i = 0; i < 150; i++)
+    env.step();
+
+  auto filename = state_file(state.range(1));
+  for (auto _ : state)
+    env.save_env_state(filename);
+
+  state.counters["bytes"] = std::filesystem::file_size(filename);
+  std::filesystem::remove(filename);
+}
+BENCHMARK(SaveEnvState)->ArgNames({"pellets", "json"})->ArgsProduct({{1000, 10000, 50000}, {1, 0}});
+
+/* restores the state of a grid environment from a file written by SaveEnvState */
+static void LoadEnvState(benchmark::State& state) {
+  GridEnvironment env(1, 4, 1000, true, state.range(0), 10, 10);
+  env.configure_observation(1, 128, true, true, true, true);
+  env.seed(0);
+  env.reset();
+  for (int i = 0; i < 150; i++)
+    env.step();
+
+  auto filename = state_file(state.range(1));
+  env.save_env_state(filename);
+  for (auto _ : state)
+    env.load_env_state(filename);
+
+  std::filesystem::remove(filename);
+}
+BENCHMARK(LoadEnvState)->ArgNames({"pellets", "json"})->ArgsProduct({{1000, 10000, 50000}, {1, 0}});
+
+/* replays a recorded 500 step game (of a grid environment with 10 bots) headless, verifying a hash every 50 steps */
+static void ReplayGame(benchmark::State& state) {
+  auto filename = (std::filesystem::temp_directory_path() / "agarcl-bench-replay.agrp").string();
+  {
+    GridEnvironment env(1, 4, 1000, true, 1000, 10, 10);
+    env.configure_observation(1, 128, true, true, true, true);
+    env.seed(0);
+    env.record_replay(filename, 50);
+    env.reset();
+    for (int i = 0; i < 500; i++) {
+      env.take_actions({agario::env::Action(std::cos(0.1 * i), std::sin(0.1 * i), agario::action::none)});
+      env.step();
+    }
+  }
+
+  long ticks = 0;
+  for (auto _ : state) {
+    auto stats = agario::env::ReplayEnvironment::replay(filename);
+    if (stats.diverged()) state.SkipWithError("replay diverged");
+    ticks += stats.ticks;
+  }
+  state.counters["ticks_per_second"] = benchmark::Counter(ticks, benchmark::Counter::kIsRate);
+  state.counters["bytes"] = std::filesystem::file_size(filename);
+  std::filesystem::remove(filename);
+}
+BENCHMARK(ReplayGame)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
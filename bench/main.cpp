@@ -1,40 +1,328 @@
 #include <benchmark/benchmark.h>
 
 #include <agario/engine/Engine.hpp>
+#include <agario/engine/internals.hpp>
 #include <agario/bots/ExampleBot.hpp>
+#include <agario/bots/bots.hpp>
+
+using Engine = agario::Engine<false>;
+using Player = agario::Player<false>;
+
+using ExampleBot = agario::bot::ExampleBot<false>;
+using HungryBot = agario::bot::HungryBot<false>;
+using HungryShyBot = agario::bot::HungryShyBot<false>;
+using AggressiveBot = agario::bot::AggressiveBot<false>;
+using AggressiveShyBot = agario::bot::AggressiveShyBot<false>;
+
+static const agario::time_delta dt(1.0 / 60);
+
+/* adds `n` players, cycling through the player types `Bots` */
+template<typename... Bots, typename E>
+static void add_bots(E &engine, int n) {
+  using AddPlayer = agario::pid (E::*)(const std::string &);
+  const std::array<AddPlayer, sizeof...(Bots)> add = {&E::template add_player<Bots>...};
+
+  for (int i = 0; i < n; i++)
+    (engine.*add[i % add.size()])(std::string());
+}
+
+/**
+ * Ticks `engine` once per iteration, starting a new game (with `restart`)
+ * after four minutes of game time so that long runs don't measure a game
+ * that has been played out.
+ */
+template<typename E, typename Restart>
+static void run_ticks(benchmark::State &state, E &engine, Restart &&restart) {
+  const int tick_limit = 4 * 3600;
+  restart();
+
+  for (auto _ : state) {
+    engine.tick(dt);
+
+    if (engine.ticks() > tick_limit) {
+      state.PauseTiming();
+      restart();
+      state.ResumeTiming();
+    }
+  }
+  state.counters["pellets"] = engine.pellet_count();
+  state.counters["viruses"] = engine.virus_count();
+  state.counters["players"] = engine.player_count();
+}
 
 static void CreateEngine(benchmark::State& state) {
   for (auto _ : state) {
-    const agario::Engine<false> engine;
+    const Engine engine;
     benchmark::DoNotOptimize(engine);
   }
 }
 BENCHMARK(CreateEngine);
 
 static void Tick(benchmark::State& state) {
-  using Bot = agario::bot::ExampleBot<false>;
+  Engine engine;
+  int num_bots = state.range(0);
+
+  run_ticks(state, engine, [&]() {
+    engine.reset();
+    add_bots<ExampleBot>(engine, num_bots);
+  });
+}
+BENCHMARK(Tick)->Arg(0)->Arg(5)->Arg(10)->Arg(20)->Arg(30);
 
-  agario::Engine<false> engine;
+/* ticks a large arena with a varying number of pellets and players roaming around eating them */
+static void TickPellets(benchmark::State& state) {
+  int num_pellets = state.range(0);
+  int num_players = 10;
+  Engine engine(5000, 5000, num_pellets, 0);
   engine.reset();
-  agario::time_delta dt(1.0 / 60);
-  int tick_limit = 4 * 3600;
 
+  for (int i = 0; i < num_players; i++)
+    engine.add_player<Player>();
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    if (engine.ticks() % 60 == 0) {
+      for (auto &pair : engine.players())
+        pair.second->target = engine.random_location();
+    }
+    state.ResumeTiming();
+
+    engine.tick(dt);
+  }
+  state.counters["pellets"] = engine.pellet_count();
+}
+BENCHMARK(TickPellets)->Arg(1000)->Arg(10000)->Arg(50000)->Arg(100000);
+
+/* ticks 10 bots of mixed types in arenas of varying size, pellet count and virus count */
+static void TickArena(benchmark::State& state) {
+  auto arena_size = state.range(0);
+  auto num_pellets = state.range(1);
+  auto num_viruses = state.range(2);
+  Engine engine(arena_size, arena_size, num_pellets, num_viruses);
+
+  run_ticks(state, engine, [&]() {
+    engine.reset();
+    add_bots<HungryBot, HungryShyBot, AggressiveBot, AggressiveShyBot>(engine, 10);
+  });
+}
+BENCHMARK(TickArena)
+  ->ArgNames({"arena", "pellets", "viruses"})
+  ->ArgsProduct({{250, 1000, 4000}, {500, 5000, 20000}, {0, 10, 100}});
+
+/* ticks the default arena with a number of bots of the given types */
+template<typename... Bots>
+static void TickBots(benchmark::State& state) {
+  Engine engine;
   int num_bots = state.range(0);
-  for (int i = 0; i < num_bots; i++)
-    engine.add_player<Bot>();
 
+  run_ticks(state, engine, [&]() {
+    engine.reset();
+    add_bots<Bots...>(engine, num_bots);
+  });
+}
+BENCHMARK_TEMPLATE(TickBots, HungryBot)->Arg(10)->Arg(30);
+BENCHMARK_TEMPLATE(TickBots, HungryShyBot)->Arg(10)->Arg(30);
+BENCHMARK_TEMPLATE(TickBots, AggressiveBot)->Arg(10)->Arg(30);
+BENCHMARK_TEMPLATE(TickBots, AggressiveShyBot)->Arg(10)->Arg(30);
+BENCHMARK_TEMPLATE(TickBots, HungryBot, HungryShyBot, AggressiveBot, AggressiveShyBot)->Arg(10)->Arg(30);
+
+/* ticks a large arena with many bots of mixed types, with the players ticked on a number of threads */
+static void TickThreads(benchmark::State& state) {
+  Engine engine(5000, 5000, 10000, 50);
+  int num_bots = state.range(0);
+  engine.set_num_threads(state.range(1));
+
+  run_ticks(state, engine, [&]() {
+    engine.reset();
+    add_bots<HungryBot, HungryShyBot, AggressiveBot, AggressiveShyBot>(engine, num_bots);
+  });
+}
+BENCHMARK(TickThreads)
+  ->ArgNames({"bots", "threads"})
+  ->ArgsProduct({{100, 300}, {1, 2, 4, 8}})
+  ->UseRealTime(); // the pool's threads do most of the work
+
+/**
+ * ticks a large arena from which a fifth of the pellets are eaten every regeneration period, with
+ * regrowth spread over ticks at the given budget (0 for all at once), and optionally placed along
+ * a low-discrepancy sequence. Reports the slowest tick as well as the mean.
+ */
+static void TickRegen(benchmark::State& state) {
+  int num_pellets = 100000;
+  Engine engine(5000, 5000, num_pellets, 0);
+  engine.set_regen_budget(state.range(0));
+  engine.set_low_discrepancy_spawns(state.range(1));
+  engine.reset();
+
+  double worst_tick = 0;
   for (auto _ : state) {
-      engine.tick(dt);
+    if (engine.ticks() % REGEN_INTERVAL_TICKS == 0) {
+      state.PauseTiming();
+      for (int p = 0; p < num_pellets / 5; p++) {
+        engine.state.pellet_index.erase(engine.pellet_count() - 1);
+        engine.state.pellets.swap_remove(engine.pellet_count() - 1);
+      }
+      state.ResumeTiming();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    engine.tick(dt);
+    worst_tick = std::max(worst_tick, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  state.counters["worst_tick_us"] = worst_tick * 1e6;
+  state.counters["pellets"] = engine.pellet_count();
+}
+BENCHMARK(TickRegen)
+  ->ArgNames({"budget", "low_discrepancy"})
+  ->ArgsProduct({{0, 500}, {0, 1}});
 
+/* ticks every game mode with 10 bots of mixed types */
+static void TickMode(benchmark::State& state) {
+  int mode = state.range(0);
+  Engine engine(1000, 1000, 1000, 10, true, mode);
+
+  run_ticks(state, engine, [&]() {
+    engine.reset();
+    add_bots<HungryBot, HungryShyBot, AggressiveBot, AggressiveShyBot>(engine, 10);
+  });
+}
+BENCHMARK(TickMode)->ArgName("mode")->DenseRange(0, 10);
+
+/* cell-cell collisions between players, each of which is split into 16 cells spread over the arena */
+static void PlayersCollision(benchmark::State& state) {
+  int num_players = state.range(0);
+  Engine engine(1000, 1000, 0, 0);
+  engine.reset();
+
+  for (int p = 0; p < num_players; p++) {
+    auto &player = engine.player(engine.add_player<Player>());
+    for (int c = 1; c < 16; c++)
+      player.add_cell(engine.random_location(), CELL_MIN_SIZE + c);
+  }
+
+  engine.players_collision(); // settle the cells that overlap from the start
+
+  int num_cells = 0;
+  for (auto &pair : engine.players())
+    num_cells += pair.second->cells.size();
+
+  for (auto _ : state)
+    engine.players_collision();
+
+  state.counters["cells"] = num_cells;
+}
+BENCHMARK(PlayersCollision)->Arg(1)->Arg(10)->Arg(30)->Arg(100);
+
+/**
+ * pushes apart the overlapping cells of a single player, which are either
+ * split into a tight clump (spread=20) or spread out so that only some of
+ * them touch (spread=200)
+ */
+static void PlayerSelfCollisions(benchmark::State& state) {
+  int num_cells = state.range(0);
+  float spread = state.range(1);
+  Engine engine(1000, 1000, 0, 0);
+  engine.reset();
+
+  agario::Rng rng(0);
+  std::uniform_real_distribution<float> offset(-spread, spread);
+
+  auto &player = engine.player(engine.add_player<Player>());
+  player.cells.clear();
+  for (int c = 0; c < num_cells; c++)
+    player.add_cell(agario::Location(500 + offset(rng), 500 + offset(rng)), 100);
+  player.target = agario::Location(500, 500);
+  auto clump = player.cells;
+
+  for (auto _ : state) {
     state.PauseTiming();
-    if (engine.ticks() > tick_limit) {
-      engine.reset();
-      for (int i = 0; i < num_bots; i++)
-        engine.add_player<Bot>();
-    }
+    player.cells = clump;
     state.ResumeTiming();
+
+    agario::EngineInternals::check_player_self_collisions(engine, player, dt);
   }
 }
-BENCHMARK(Tick)->Arg(0)->Arg(5)->Arg(10)->Arg(20)->Arg(30);
+BENCHMARK(PlayerSelfCollisions)
+  ->ArgNames({"cells", "spread"})
+  ->ArgsProduct({benchmark::CreateRange(2, 64, 2), {20, 200}});
+
+/* moves a number of freshly emitted foods (which stop after ~75 ticks) in an arena with the default viruses */
+static void MoveFoods(benchmark::State& state) {
+  int num_foods = state.range(0);
+  Engine engine(1000, 1000, 0, DEFAULT_NUM_VIRUSES);
+  agario::Rng rng(0);
+  std::uniform_real_distribution<float> angle(0, 2 * M_PI);
+
+  auto emit = [&]() {
+    engine.reset();
+    for (int f = 0; f < num_foods; f++) {
+      agario::Velocity vel(agario::angle(angle(rng)), agario::distance(FOOD_SPEED));
+      engine.state.foods.emplace_back(engine.random_location(), vel);
+    }
+  };
+
+  int moves = 0;
+  emit();
+  for (auto _ : state) {
+    agario::EngineInternals::move_foods(engine, dt);
+
+    if (++moves % 60 == 0) {
+      state.PauseTiming();
+      emit();
+      state.ResumeTiming();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_foods);
+}
+BENCHMARK(MoveFoods)->RangeMultiplier(10)->Range(100, 100000);
+
+/* moves 100 foods that keep being fired across an arena littered with a number of foods at rest */
+static void MoveFoodsAmongResting(benchmark::State& state) {
+  int num_resting = state.range(0);
+  int num_moving = 100;
+  Engine engine(1000, 1000, 0, DEFAULT_NUM_VIRUSES);
+  agario::Rng rng(0);
+  std::uniform_real_distribution<float> angle(0, 2 * M_PI);
+
+  engine.reset();
+  for (int f = 0; f < num_resting; f++)
+    engine.state.foods.emplace_back(engine.random_location(), agario::Velocity());
+
+  int moves = 0;
+  for (auto _ : state) {
+    if (moves++ % 60 == 0) {
+      state.PauseTiming();
+      for (int f = 0; f < num_moving; f++) {
+        agario::Velocity vel(agario::angle(angle(rng)), agario::distance(FOOD_SPEED));
+        engine.state.foods.emplace_back(engine.random_location(), vel);
+      }
+      state.ResumeTiming();
+    }
+    agario::EngineInternals::move_foods(engine, dt);
+  }
+  state.counters["foods"] = engine.food_count();
+}
+BENCHMARK(MoveFoodsAmongResting)->RangeMultiplier(10)->Range(1000, 100000);
+
+/* ticks a number of large players that keep feeding (W) at random targets, with bots around eating the foods */
+static void TickFeeding(benchmark::State& state) {
+  int num_feeders = state.range(0);
+  Engine engine(2000, 2000, 1000, DEFAULT_NUM_VIRUSES);
+  agario::Rng rng(0);
+  std::uniform_real_distribution<float> coord(0, 2000);
+
+  run_ticks(state, engine, [&]() {
+    engine.reset();
+    for (int i = 0; i < num_feeders; i++) {
+      auto &player = engine.player(engine.add_player<Player>());
+      player.cells.front().set_mass(5000);
+      player.target = agario::Location(coord(rng), coord(rng));
+      player.action = agario::action::feed;
+    }
+    add_bots<HungryBot, AggressiveBot>(engine, 10);
+  });
+  state.counters["foods"] = engine.food_count();
+}
+BENCHMARK(TickFeeding)->Arg(5)->Arg(20)->Arg(50);
 
 BENCHMARK_MAIN();
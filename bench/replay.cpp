@@ -0,0 +1,35 @@
+/**
+ * Replays a replay log (see environment/envs/replay_log.hpp) headless and as
+ * fast as the engine can tick, verifying it against the log's state hashes.
+ * Doubles as a throughput benchmark on real recorded games.
+ *
+ *   agario-replay LOG [--keep-going]
+ *
+ * exits with 1 if the replay diverged from the recorded game
+ */
+#include <cstring>
+#include <iostream>
+
+#include <environment/envs/ReplayEnvironment.hpp>
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " LOG [--keep-going]" << std::endl;
+    return 2;
+  }
+  bool keep_going = argc > 2 && std::strcmp(argv[2], "--keep-going") == 0;
+
+  auto stats = agario::env::ReplayEnvironment::replay(argv[1], keep_going);
+  std::cout << "resets:         " << stats.resets << std::endl
+            << "steps:          " << stats.steps << std::endl
+            << "ticks:          " << stats.ticks << std::endl
+            << "hashes checked: " << stats.hashes_checked << std::endl
+            << "seconds:        " << stats.seconds << std::endl
+            << "ticks/second:   " << stats.ticks_per_second() << std::endl;
+
+  if (stats.diverged()) {
+    std::cout << "DIVERGED at step " << stats.diverged_step << std::endl;
+    return 1;
+  }
+  return 0;
+}
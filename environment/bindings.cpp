@@ -6,7 +6,9 @@
 #include <tuple>
 #include <iostream>
 #include <environment/envs/GridEnvironment.hpp>
+#include <environment/envs/VecGridEnvironment.hpp>
 #include <environment/envs/GoBiggerEnvironment.hpp>
+#include <environment/envs/ReplayEnvironment.hpp>
 
 #ifdef INCLUDE_SCREEN_ENV
 #include <environment/envs/ScreenEnvironment.hpp>
@@ -14,8 +16,22 @@
 
 #include <environment/renderable.hpp>
 
+#ifdef AGARIO_PROFILE
+#include <agario/utils/count_allocations.hpp>
+#endif
+
 namespace py = pybind11;
 
+/* float16 observations become NumPy float16 arrays (pybind11 has no half precision type of its own) */
+template <>
+struct pybind11::detail::npy_format_descriptor<agario::env::float16> {
+  static constexpr auto name = const_name("float16");
+  static pybind11::dtype dtype() {
+    constexpr int NPY_HALF = 23;
+    return reinterpret_steal<pybind11::dtype>(npy_api::get().PyArray_DescrFromType_(NPY_HALF));
+  }
+};
+
 template <class Tuple,
   class T = std::decay_t<std::tuple_element_t<0, std::decay_t<Tuple>>>>
 std::vector<T> to_vector(Tuple&& tuple) {
@@ -46,6 +62,21 @@ py::list get_state_goBigger(const agario::env::GoBiggerEnvironment<renderable>&
     return state_list;
 }
 
+/* a capsule holding a reference to `owner`, as the base of NumPy views into the memory that it owns */
+template <typename T>
+py::capsule share(std::shared_ptr<T> owner) {
+  auto *held = new std::shared_ptr<T>(std::move(owner));
+  return py::capsule(held, [](void *ptr) { delete reinterpret_cast<std::shared_ptr<T> *>(ptr); });
+}
+
+/* a read-only NumPy view of a C-contiguous, shared `buffer` with the given shape, which holds on to the buffer */
+template <typename T, typename Shape>
+py::array_t<T> to_view(const std::shared_ptr<const std::vector<T>> &buffer, const Shape &shape) {
+  auto view = py::array_t<T>(to_vector(shape), buffer->data(), share(buffer));
+  view.attr("setflags")(py::arg("write") = false);
+  return view;
+}
+
 /* converts a python list of actions to the C++ action wrapper */
 std::vector<agario::env::Action> to_action_vector(const py::list &actions) {
   std::vector<agario::env::Action> acts;
@@ -63,21 +94,38 @@ std::vector<agario::env::Action> to_action_vector(const py::list &actions) {
   return acts;
 }
 
-/* extracts observations from each agent, wrapping them in NumPy arrays */
+/**
+ * extracts observations from each agent, wrapping them in NumPy arrays.
+ * Double buffered environments hand out read-only views of their observation
+ * buffers rather than copies, which hold on to the buffers (not the
+ * environment), so that they outlive reconfiguring or copying into it.
+ */
 template <typename Environment>
-py::list get_state(const Environment &environment) {
+py::list get_state(const py::object &self) {
   using dtype = typename Environment::dtype;
 
+  const auto &environment = self.cast<const Environment &>();
   auto &observations = environment.get_observations();
   py::list obs;
   for (auto &observation : observations) {
-    // make a copy of the data for the numpy array to take ownership of
-    auto *data = new dtype[observation.length()];
-    std::copy(observation.data(), observation.data() + observation.length(), data);
-
     const auto &shape = observation.shape();
     const auto &strides = observation.strides();
 
+    if (environment.double_buffered()) {
+      auto view = py::array_t<dtype>(to_vector(shape), to_vector(strides), observation.data(),
+                                     share(observation.buffer()));
+      view.attr("setflags")(py::arg("write") = false);
+      obs.append(view);
+      continue;
+    }
+
+    // make a copy of the data for the numpy array to take ownership of
+    auto *data = new dtype[observation.length()];
+    {
+      py::gil_scoped_release release;
+      std::copy(observation.data(), observation.data() + observation.length(), data);
+    }
+
     py::capsule cleanup(data, [](void *ptr) {
       auto *data_pointer = reinterpret_cast<dtype*>(ptr);
       delete[] data_pointer;
@@ -91,34 +139,54 @@ py::list get_state(const Environment &environment) {
 }
 
 
-PYBIND11_MODULE(agarcl, module) {
-  using namespace py::literals;
-  module.doc() = "Agar.io Learning Environment";
+/**
+ * configures the observations of a (vectorized) grid environment from a dict of
+ * the GridObservation parameters. "mass_scale" is the scale that masses are
+ * divided by in compact observations (see environment/envs/quantization.hpp)
+ */
+template <typename Environment>
+void configure_grid_observation(Environment &env, const py::dict &config) {
+  using dtype = typename Environment::dtype;
 
-  /* ================ Grid Environment ================ */
-  using GridEnvironment = agario::env::GridEnvironment<int, renderable>;
+  int num_frames   = config.contains("num_frames")      ? config["num_frames"].cast<int>() : 1;
+  int grid_size    = config.contains("grid_size")       ? config["grid_size"].cast<int>() : DEFAULT_GRID_SIZE;
+  bool cells       = config.contains("observe_cells")   ? config["observe_cells"].cast<bool>()   : true;
+  bool others      = config.contains("observe_others")  ? config["observe_others"].cast<bool>()  : true;
+  bool viruses     = config.contains("observe_viruses") ? config["observe_viruses"].cast<bool>() : true;
+  bool pellets     = config.contains("observe_pellets") ? config["observe_pellets"].cast<bool>() : true;
+  float mass_scale = config.contains("mass_scale") && !config["mass_scale"].is_none()
+                     ? config["mass_scale"].cast<float>() : agario::env::default_mass_scale<dtype>();
 
-  py::class_<GridEnvironment>(module, "GridEnvironment")
-    .def(py::init<int, int, int, bool, int, int, int, int, int, int>())
-    .def("seed", &GridEnvironment::seed)
-    .def("configure_observation", [](GridEnvironment &env, const py::dict &config) {
+  env.configure_observation(num_frames, grid_size, cells, others, viruses, pellets, mass_scale);
+}
 
-      int num_frames = config.contains("num_frames")      ? config["num_frames"].cast<int>() : 1;
-      int grid_size  = config.contains("grid_size")       ? config["grid_size"].cast<int>() : DEFAULT_GRID_SIZE;
-      bool cells     = config.contains("observe_cells")   ? config["observe_cells"].cast<bool>()   : true;
-      bool others    = config.contains("observe_others")  ? config["observe_others"].cast<bool>()  : true;
-      bool viruses   = config.contains("observe_viruses") ? config["observe_viruses"].cast<bool>() : true;
-      bool pellets   = config.contains("observe_pellets") ? config["observe_pellets"].cast<bool>() : true;
+/* binds the grid environment with observations of type `T` as `name` */
+template <typename T>
+void bind_grid_environment(py::module &module, const char *name) {
+  using GridEnvironment = agario::env::GridEnvironment<T, renderable>;
 
-      env.configure_observation(num_frames, grid_size, cells, others, viruses, pellets);
-    })
+  py::class_<GridEnvironment>(module, name)
+    .def(py::init<int, int, int, bool, int, int, int, int, int, int>())
+    .def("seed", &GridEnvironment::seed)
+    .def("profile", &GridEnvironment::profile)
+    .def("reset_profile", &GridEnvironment::reset_profile)
+    .def("set_num_threads", &GridEnvironment::set_num_threads)
+    .def("num_threads", &GridEnvironment::num_threads)
+    .def("configure_regen", &GridEnvironment::configure_regen,
+         py::arg("budget"), py::arg("low_discrepancy") = false)
+    .def("configure_observation", &configure_grid_observation<GridEnvironment>)
     .def("observation_shape", &GridEnvironment::observation_shape)
+    .def("set_double_buffered", &GridEnvironment::set_double_buffered)
+    .def("double_buffered", &GridEnvironment::double_buffered)
     .def("dones", &GridEnvironment::dones)
     .def("take_actions", [](GridEnvironment &env, const py::list &actions) {
       env.take_actions(to_action_vector(actions));
     })
     .def("get_frame", []( GridEnvironment &env) {
-      auto& observation = env.get_frame();
+      auto& observation = [&env]() -> auto & {
+        py::gil_scoped_release release; // rendering the frame needs no Python objects
+        return env.get_frame();
+      }();
       auto data = (void *)observation.frame_data();
       auto shape = observation.frame_shape();
       auto strides = observation.frame_strides();
@@ -127,12 +195,97 @@ PYBIND11_MODULE(agarcl, module) {
       auto arr = py::array_t<std::uint8_t>(buffer);
       return arr;
     })
-    .def("reset", &GridEnvironment::reset)
+    .def("reset", &GridEnvironment::reset, py::call_guard<py::gil_scoped_release>())
     .def("render", &GridEnvironment::render)
-    .def("step", &GridEnvironment::step)
+    .def("step", &GridEnvironment::step, py::call_guard<py::gil_scoped_release>())
     .def("get_state", &get_state<GridEnvironment>)
     .def("close", &GridEnvironment::close)
-    .def("save_env_state", &GridEnvironment::save_env_state);
+    .def("save_env_state", &GridEnvironment::save_env_state)
+    .def("clone", &GridEnvironment::clone, py::call_guard<py::gil_scoped_release>())
+    .def("copy_state_from", &GridEnvironment::copy_state_from, py::call_guard<py::gil_scoped_release>())
+    .def("log_observations", &GridEnvironment::log_observations,
+         py::arg("filename"), py::arg("keyframe_interval") = 100)
+    .def("stop_logging", &GridEnvironment::stop_logging)
+    .def("logging", &GridEnvironment::logging)
+    .def("record_replay", &GridEnvironment::record_replay,
+         py::arg("filename"), py::arg("hash_interval") = 0)
+    .def("stop_recording", &GridEnvironment::stop_recording)
+    .def("recording", &GridEnvironment::recording);
+}
+
+/* binds the vectorized grid environment with observations of type `T` as `name` */
+template <typename T>
+void bind_vec_grid_environment(py::module &module, const char *name) {
+  using VecGridEnvironment = agario::env::VecGridEnvironment<T, renderable>;
+
+  py::class_<VecGridEnvironment>(module, name)
+    .def(py::init<int, int, int, int, bool, int, int, int, int, int, int, int>())
+    .def("seed", &VecGridEnvironment::seed)
+    .def("profile", &VecGridEnvironment::profile)
+    .def("reset_profile", &VecGridEnvironment::reset_profile)
+    .def("num_envs", &VecGridEnvironment::num_envs)
+    .def("configure_regen", &VecGridEnvironment::configure_regen,
+         py::arg("budget"), py::arg("low_discrepancy") = false)
+    .def("configure_observation", &configure_grid_observation<VecGridEnvironment>)
+    .def("observation_shape", &VecGridEnvironment::observation_shape)
+    .def("reset", &VecGridEnvironment::reset, py::call_guard<py::gil_scoped_release>())
+    .def("step", [](VecGridEnvironment &env, const py::array_t<float, py::array::c_style | py::array::forcecast> &actions) {
+      if (actions.ndim() != 2 || actions.shape(0) != env.num_envs() || actions.shape(1) != 3)
+        throw agario::env::EnvironmentException("Actions must have shape (" + std::to_string(env.num_envs()) + ", 3)");
+
+      {
+        py::gil_scoped_release release;
+        env.step(actions.data());
+      }
+
+      int n = env.num_envs();
+      py::array_t<double> rewards(n);
+      py::array_t<bool> dones(n);
+      py::array_t<bool> truncations(n);
+      std::copy(env.rewards().begin(), env.rewards().end(), rewards.mutable_data());
+      std::copy(env.dones().begin(), env.dones().end(), dones.mutable_data());
+      std::copy(env.truncations().begin(), env.truncations().end(), truncations.mutable_data());
+
+      return py::make_tuple(to_view(env.observation_buffer(), env.observation_shape()), rewards, dones, truncations);
+    })
+    .def("get_state", [](const VecGridEnvironment &env) {
+      return to_view(env.observation_buffer(), env.observation_shape());
+    })
+    .def("final_observations", [](const VecGridEnvironment &env) {
+      return to_view(env.final_observation_buffer(), env.observation_shape());
+    });
+}
+
+PYBIND11_MODULE(agarcl, module) {
+  using namespace py::literals;
+  module.doc() = "Agar.io Learning Environment";
+
+  /* ================ Grid Environment ================ */
+  /* one class per observation dtype: int32 holds raw masses, the others are quantized */
+  bind_grid_environment<int>(module, "GridEnvironment");
+  bind_grid_environment<std::uint16_t>(module, "GridEnvironmentUInt16");
+  bind_grid_environment<std::uint8_t>(module, "GridEnvironmentUInt8");
+  bind_grid_environment<agario::env::float16>(module, "GridEnvironmentFloat16");
+
+  /* ================ Replays ================ */
+  /* re-runs a log written by an environment's record_replay, headless */
+  module.def("replay", [](const std::string &filename, bool keep_going) {
+    agario::env::ReplayStats stats;
+    {
+      py::gil_scoped_release release;
+      stats = agario::env::ReplayEnvironment::replay(filename, keep_going);
+    }
+    return py::dict("steps"_a=stats.steps, "ticks"_a=stats.ticks, "resets"_a=stats.resets,
+                    "hashes_checked"_a=stats.hashes_checked, "diverged"_a=stats.diverged(),
+                    "diverged_step"_a=stats.diverged_step, "seconds"_a=stats.seconds,
+                    "ticks_per_second"_a=stats.ticks_per_second());
+  }, py::arg("filename"), py::arg("keep_going") = false);
+
+  /* ================ Vectorized Grid Environment ================ */
+  bind_vec_grid_environment<int>(module, "VecGridEnvironment");
+  bind_vec_grid_environment<std::uint16_t>(module, "VecGridEnvironmentUInt16");
+  bind_vec_grid_environment<std::uint8_t>(module, "VecGridEnvironmentUInt8");
+  bind_vec_grid_environment<agario::env::float16>(module, "VecGridEnvironmentFloat16");
 
   /* ================ Screen Environment ================ */
   /* we only include this conditionally if OpenGL was found available for linking */
@@ -145,14 +298,20 @@ PYBIND11_MODULE(agarcl, module) {
 
    .def(pybind11::init<int, int, int, bool, int, int, int,bool,int, int, bool, screen_len, screen_len, bool>())
    .def("seed", &ScreenEnvironment::seed)
+   .def("profile", &ScreenEnvironment::profile)
+   .def("reset_profile", &ScreenEnvironment::reset_profile)
+   .def("set_num_threads", &ScreenEnvironment::set_num_threads)
+   .def("num_threads", &ScreenEnvironment::num_threads)
+   .def("configure_regen", &ScreenEnvironment::configure_regen,
+        py::arg("budget"), py::arg("low_discrepancy") = false)
    .def("observation_shape", &ScreenEnvironment::observation_shape)
    .def("dones", &ScreenEnvironment::dones)
    .def("take_actions", [](ScreenEnvironment &env, const py::list &actions) {
      env.take_actions(to_action_vector(actions));
    })
-   .def("reset", &ScreenEnvironment::reset)
+   .def("reset", &ScreenEnvironment::reset, py::call_guard<py::gil_scoped_release>())
    .def("render", &ScreenEnvironment::render)
-   .def("step", &ScreenEnvironment::step)
+   .def("step", &ScreenEnvironment::step, py::call_guard<py::gil_scoped_release>())
     // .def("get_state", &get_state<ScreenEnvironment>);
     .def("get_state", []( ScreenEnvironment &env) {
       py::list obs;
@@ -367,10 +526,20 @@ PYBIND11_MODULE(agarcl, module) {
       .def("dones", &GoBiggerEnv::dones)
       .def("observation_shape", &GoBiggerEnv::observation_shape)
       .def("seed", &GoBiggerEnv::seed, "Seed the environment")
-      .def("reset", &GoBiggerEnv::reset, "Reset the environment")
-      .def("step", &GoBiggerEnv::step, "Step through the environment")
+      .def("profile", &GoBiggerEnv::profile, "Per-phase tick profile (empty unless built with AGARIO_PROFILE)")
+      .def("reset_profile", &GoBiggerEnv::reset_profile)
+      .def("set_num_threads", &GoBiggerEnv::set_num_threads, "Tick the players on this many threads")
+      .def("num_threads", &GoBiggerEnv::num_threads)
+      .def("configure_regen", &GoBiggerEnv::configure_regen, "Spread regeneration over ticks",
+           py::arg("budget"), py::arg("low_discrepancy") = false)
+      .def("reset", &GoBiggerEnv::reset, "Reset the environment", py::call_guard<py::gil_scoped_release>())
+      .def("step", &GoBiggerEnv::step, "Step through the environment", py::call_guard<py::gil_scoped_release>())
       .def("render", &GoBiggerEnv::render, "Render the current state")
       .def("close", &GoBiggerEnv::close, "Close the environment")
       .def("load_env_state", &GoBiggerEnv::load_env_state)
-      .def("save_env_state", &GoBiggerEnv::save_env_state);
+      .def("save_env_state", &GoBiggerEnv::save_env_state)
+      .def("record_replay", &GoBiggerEnv::record_replay,
+           py::arg("filename"), py::arg("hash_interval") = 0)
+      .def("stop_recording", &GoBiggerEnv::stop_recording)
+      .def("recording", &GoBiggerEnv::recording);
 }
@@ -6,10 +6,14 @@
 #include <agario/core/Ball.hpp>
 #include <agario/bots/bots.hpp>
 #include "agario/engine/GameState.hpp"
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <dependencies/json.hpp>
 #include <tuple>
 #include <agario/utils/json.hpp>
+#include <environment/profiled.hpp>
+#include <environment/envs/replay_log.hpp>
 // 30 frames per second: the default amount of time between frames of the game
 #define DEFAULT_DT (1.0 / 30.0)
 
@@ -118,6 +122,9 @@ namespace agario {
           for (int i = 0; i < num_agents(); ++i)
             rewards[i] -= (before[i] - ((is_main_player_respawned) ? c_death_ : 0));
         }
+
+        if (replay_log_ && replay_log_->step())
+          replay_log_->hash(engine_.state_hash());
         return rewards;
       }
 
@@ -165,6 +172,7 @@ namespace agario {
         auto &player = engine_.player(pid);
 
         if (player.dead()) return; // its okay to take action on a dead player
+        if (replay_log_) replay_log_->action(pid, dx, dy, static_cast<std::uint8_t>(action));
 
         /* todo: this isn't exactly "calibrated" such such that
          * dx = 1 means move exactly the maximum speed */
@@ -179,6 +187,7 @@ namespace agario {
       virtual void reset() {
         if(this->is_loading_env_state == true)
           return;
+        if (replay_log_) replay_log_->reset(engine_.state.rng.state());
         engine_.reset();
         pids_.clear();
         // c_death_ = 0;
@@ -209,8 +218,138 @@ namespace agario {
       virtual void render() {};
 
       void seed (int s) { engine_.seed(s); seed_ = s; }
-      // Save the environment state to a file
+
+      /* per-phase tick profile of the engine (empty unless built with AGARIO_PROFILE) */
+      [[nodiscard]] std::map<std::string, double> profile() const { return engine_.profile(); }
+      void reset_profile() { engine_.reset_profile(); }
+
+      /**
+       * ticks the engine's players on `num_threads` threads (see
+       * Engine::set_num_threads). Replays record this configuration, since
+       * games on one thread and on several play out differently.
+       */
+      void set_num_threads(int num_threads) {
+        if (replay_log_)
+          throw EnvironmentException("Can't change the number of threads while recording a replay.");
+        engine_.set_num_threads(num_threads);
+      }
+      [[nodiscard]] int num_threads() const { return engine_.num_threads(); }
+
+      /**
+       * spreads the regeneration of pellets and viruses over ticks, adding at
+       * most `budget` per tick (0 for no limit, see Engine::set_regen_budget),
+       * and places them along a low-discrepancy sequence from the next reset
+       * if `low_discrepancy`. Replays record this configuration.
+       */
+      void configure_regen(int budget, bool low_discrepancy = false) {
+        if (replay_log_)
+          throw EnvironmentException("Can't configure regeneration while recording a replay.");
+        engine_.set_regen_budget(budget);
+        engine_.set_low_discrepancy_spawns(low_discrepancy);
+      }
+
+      [[nodiscard]] int regen_budget() const { return engine_.regen_budget(); }
+
+      /**
+       * makes this environment's game and agents a copy of `other`'s (see
+       * Engine::copy_state_from), which must have the same number of agents,
+       * ticks per step and game configuration
+       */
+      void copy_state_from(const BaseEnvironment &other) {
+        if (&other == this) return;
+        if (num_agents_ != other.num_agents_ || ticks_per_step_ != other.ticks_per_step_)
+          throw EnvironmentException("Can't copy the state of an environment with different agents or ticks per step");
+        if (replay_log_)
+          throw EnvironmentException("Can't copy a state while recording a replay.");
+
+        engine_.copy_state_from(other.engine_);
+        pids_ = other.pids_;
+        dones_ = other.dones_;
+        c_death_ = other.c_death_;
+        seed_ = other.seed_;
+        curr_mode_number = other.curr_mode_number;
+        is_main_player_respawned = other.is_main_player_respawned;
+        is_loading_env_state = other.is_loading_env_state;
+      }
+
+      /**
+       * Records a replay log of the environment to `filename` (see
+       * replay_log.hpp), from the next reset until stop_recording is called:
+       * the RNG state at every reset and the actions taken before every step,
+       * from which ReplayEnvironment re-runs the game exactly. With a
+       * `hash_interval`, a hash of the game is also recorded every that many
+       * steps, so that replays can tell where they diverge.
+       */
+      void record_replay(const std::string &filename, int hash_interval = 0) {
+        if (hash_interval < 0)
+          throw EnvironmentException("Replay hash interval must not be negative.");
+
+        ReplayHeader header = {};
+        header.num_agents = num_agents_;
+        header.ticks_per_step = ticks_per_step_;
+        header.arena_size = static_cast<int>(engine_.arena_width());
+        header.pellet_regen = engine_.pellet_regen();
+        header.num_pellets = engine_.get_game_state().config.target_num_pellets;
+        header.num_viruses = engine_.get_game_state().config.target_num_viruses;
+        header.num_bots = num_bots_;
+        header.reward_type = reward_type_;
+        header.c_death = c_death_;
+        header.mode_number = curr_mode_number;
+        header.seed = seed_;
+        header.hash_interval = hash_interval;
+        header.regen_budget = engine_.regen_budget();
+        header.low_discrepancy_spawns = engine_.low_discrepancy_spawns();
+        header.num_threads = engine_.num_threads();
+
+        replay_log_.reset(); // closes the previous log before opening the next (which may be the same file)
+        replay_log_ = std::make_unique<ReplayLogWriter>(filename, header);
+      }
+
+      /* closes the replay log, if one is open */
+      void stop_recording() { replay_log_.reset(); }
+
+      [[nodiscard]] bool recording() const { return replay_log_ != nullptr; }
+
+      /* read-only access to the game engine that the environment wraps */
+      [[nodiscard]] const Engine<renderable, profiled> &engine() const { return engine_; }
+
+      /**
+       * Saves the environment state to `filename`, to be restored by
+       * load_env_state. Files named *.json get a (slow, human readable) JSON
+       * export for debugging, anything else gets a binary snapshot (see
+       * agario/utils/snapshot.hpp). load_env_state reads either.
+       */
       void save_env_state(const std::string &filename) const {
+        auto ext = std::filesystem::path(filename).extension();
+        if (ext == ".json")
+          export_env_state_json(filename);
+        else
+          save_env_snapshot(filename);
+      }
+
+      /* saves the environment state as a binary snapshot, whatever the file is named */
+      void save_env_snapshot(const std::string &filename) const {
+        snapshot::Header header = {};
+        std::memcpy(header.magic, snapshot::magic, sizeof(header.magic));
+        header.version = snapshot::version;
+        header.num_agents = num_agents_;
+        header.ticks_per_step = ticks_per_step_;
+        header.arena_size = static_cast<int>(engine_.arena_width());
+        header.num_bots = num_bots_;
+        header.reward_type = reward_type_;
+        header.seed = seed_;
+        header.c_death = c_death_;
+        header.mode_number = engine_.mode_number;
+        header.pellet_regen = engine_.pellet_regen();
+
+        snapshot::Writer out(filename);
+        out.write(header);
+        engine_.save_snapshot(out);
+        out.close();
+      }
+
+      /* saves the environment state as JSON, whatever the file is named */
+      void export_env_state_json(const std::string &filename) const {
         using json = nlohmann::json;
 
         // std::ifstream in_file(filename);
@@ -318,6 +457,8 @@ namespace agario {
       }
 
       void load_env_state(const std::string &filename) {
+        if (replay_log_)
+          throw EnvironmentException("Can't load a state while recording a replay.");
         this->is_loading_env_state =  true;
         engine_.reset_state();
         pids_.clear();
@@ -343,7 +484,7 @@ namespace agario {
       }
 
     protected:
-      Engine <renderable> engine_;
+      Engine <renderable, profiled> engine_;
       std::vector<agario::pid> pids_;
       mutable std::vector<bool> dones_;
       int c_death_;
@@ -366,6 +507,7 @@ namespace agario {
       virtual void _partial_observation(Player &player, int tick_index) {};
 
       bool is_loading_env_state = false;
+      std::unique_ptr<ReplayLogWriter> replay_log_;
 
 
 
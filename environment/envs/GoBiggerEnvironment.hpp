@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 
 #include <unordered_map>
@@ -256,6 +257,7 @@ namespace agario::env {
         PlayerStates player_states;
         int no_frames;
         std::vector<dtype> observation_data;
+        std::vector<int> visible_ids_; // scratch space for the entities found in a player's view
 
     public:
         using GameState = GameState<R>;
@@ -423,12 +425,13 @@ namespace agario::env {
             return agario::clamp<float>(2 * player.mass(), 100, 300);
         }
 
-        void _world_to_grid(const Player &player, const Location &loc,
+        // `center` is the player's center of mass, computed once by the caller
+        void _world_to_grid(const Location &center, const Location &loc,
                             float view_size, int &gx, int &gy) const
         {
             float centering = static_cast<float>(config_.grid_size) / 2.f;
-            float diff_x = loc.x - player.x();
-            float diff_y = loc.y - player.y();
+            float diff_x = loc.x - center.x;
+            float diff_y = loc.y - center.y;
 
             gx = static_cast<int>((config_.grid_size * diff_x / view_size) + centering);
             gy = static_cast<int>((config_.grid_size * diff_y / view_size) + centering);
@@ -443,26 +446,31 @@ namespace agario::env {
             return player.location() + Location(dx, dy);
         }
 
-        template<typename U>
-        void _store_entities(const std::vector<U> &entities,
+        template<typename U, typename Entities>
+        void _store_entities(const Entities &entities,
                             const Player &player,
                             PlayerState &ps,
                             int pid,
                             int channel,
-                            calc_type ctype = calc_type::total_mass_)
+                            calc_type ctype = calc_type::total_mass_,
+                            const SpatialHash *index = nullptr)
         {
+            // the view only depends on the player, so compute it once rather than per entity
             float view_size = _view_size(player);
+            Location center = player.location();
+            agario::mass player_mass = player.mass();
 
             int grid_x = 0, grid_y = 0;
+            bool stored = false;
 
-            for (auto &entity : entities) {
-                _world_to_grid(player, entity.location(), view_size, grid_x, grid_y);
+            auto store = [&](const auto &entity) {
+                _world_to_grid(center, entity.location(), view_size, grid_x, grid_y);
 
                 if (_inside_grid(grid_x, grid_y)) {
                     if constexpr (std::is_same_v<U, Pellet>) {
                         FoodInfo info = {
-                            agario::Location(entity.location().x - player.x(),
-                                             entity.location().y - player.y()),
+                            agario::Location(entity.location().x - center.x,
+                                             entity.location().y - center.y),
                             entity.radius(),
                             entity.mass()
                         };
@@ -470,8 +478,8 @@ namespace agario::env {
                     }
                     else if constexpr (std::is_same_v<U, Virus>) {
                         VirusInfo info = {
-                            agario::Location(entity.location().x - player.x(),
-                            entity.location().y - player.y()),
+                            agario::Location(entity.location().x - center.x,
+                            entity.location().y - center.y),
                             entity.radius(),
                             entity.mass(),
                             std::make_pair(0,0)
@@ -480,8 +488,8 @@ namespace agario::env {
                     }
                     else if constexpr (std::is_same_v<U, Food>) {
                         SporeInfo info = {
-                            agario::Location(entity.location().x - player.x(),
-                            entity.location().y - player.y()),
+                            agario::Location(entity.location().x - center.x,
+                            entity.location().y - center.y),
                             entity.radius(),
                             entity.mass(),
                             std::make_pair(0,0),
@@ -491,8 +499,8 @@ namespace agario::env {
                     }
                     else if constexpr (std::is_same_v<U, Cell>) {
                         CloneInfo info = {
-                            agario::Location(entity.location().x - player.x(),
-                            entity.location().y - player.y()),
+                            agario::Location(entity.location().x - center.x,
+                            entity.location().y - center.y),
                             entity.radius(),
                             entity.mass(),
                             std::make_pair( entity.get_velocity().dx, entity.get_velocity().dy ),
@@ -505,10 +513,30 @@ namespace agario::env {
                     else {
                         throw std::runtime_error("Unknown entity type in _store_entities");
                     }
-                    ps.update_score(player.mass());
-                    // commit updated player state
-                    player_states.update_player_state(pid, ps);
+                    stored = true;
                 }
+            };
+
+            if (index != nullptr) {
+                // only visit the entities that the index finds in the view (grid
+                // coordinates are truncated toward zero, hence the extra square),
+                // in index order so that the infos are listed as without the index
+                float reach = view_size / 2 + view_size / config_.grid_size;
+                visible_ids_.clear();
+                index->for_each_in(center.x - reach, center.y - reach, center.x + reach, center.y + reach,
+                                   [&](int id) { visible_ids_.push_back(id); });
+                std::sort(visible_ids_.begin(), visible_ids_.end());
+                for (int id : visible_ids_)
+                    store(entities[id]);
+            } else {
+                for (auto &entity : entities)
+                    store(entity);
+            }
+
+            if (stored) {
+                ps.update_score(player_mass);
+                // commit updated player state
+                player_states.update_player_state(pid, ps);
             }
         }
 
@@ -538,7 +566,7 @@ namespace agario::env {
                 _store_entities<Virus>(game_state.viruses, *pl, pstate,
                        pid, channel, calc_type::total_mass_);
                 _store_entities<Pellet>(game_state.pellets, *pl, pstate,
-                          pid, channel, calc_type::total_mass_);
+                          pid, channel, calc_type::total_mass_, &game_state.pellet_index);
                 _store_entities<Food>(game_state.foods, *pl, pstate,
                         pid, channel, calc_type::total_mass_);
                 _store_entities<Cell>(pl->cells, *pl, pstate,
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
 #include <agario/engine/Engine.hpp>
 #include <agario/core/types.hpp>
@@ -10,6 +11,8 @@
 #include <agario/engine/GameState.hpp>
 
 #include "environment/envs/BaseEnvironment.hpp"
+#include "environment/envs/quantization.hpp"
+#include "environment/envs/observation_log.hpp"
 
 #ifdef RENDERABLE
 #include <agario/core/renderables.hpp>
@@ -22,6 +25,12 @@
 
 namespace agario::env {
 
+    /**
+     * A grid observation of the world around a player, with one channel per
+     * kind of entity in each frame. `T` is the type of the grid squares: with
+     * int (or float) they hold raw masses, and with a compact type (uint8,
+     * uint16 or float16, see quantization.hpp) they are quantized per channel.
+     */
     template<typename T, bool renderable>
     class GridObservation {
       using GameState = GameState<renderable>;
@@ -44,35 +53,60 @@ namespace agario::env {
       using Strides = std::tuple<ssize_t, ssize_t, ssize_t>;
 
       /* construct without configuring. configure() must be called. */
-      GridObservation() : data_(nullptr) { }
+      GridObservation() = default;
 
       /* construct with configuration. configure() need not be called */
       template <typename ...Args>
       explicit GridObservation(Args&&... args) : config_(args...) {
         _make_shapes();
-        data_ = new dtype[length()];
-        clear_data();
+        _allocate_frames();
       }
 
       /* configures the observation for a particular size */
       template <typename ...Args>
       void configure(Args&&... args) {
         config_(args...);
+        _make_shapes();
+        _allocate_frames();
+      }
 
-        delete[] data_; // might be nullptr, thats ok
+      /**
+       * Enables (or disables) double buffering: an observation that was
+       * returned stays untouched through the following step (or the start of
+       * the next episode), so that it can be read without a copy. The ring
+       * of frames holds twice as many frames as the observation shows for
+       * this, so that both write into frames that it does not show.
+       * (Re)allocates the frames, clearing the frame history.
+       */
+      void set_double_buffered(bool double_buffered) {
+        if (!configured())
+          throw EnvironmentException("GridObservation was not configured.");
+        if (double_buffered == double_buffered_) return;
 
-        _make_shapes();
-        data_ = new dtype[length()];
-        clear_data();
+        double_buffered_ = double_buffered;
+        _allocate_frames();
       }
 
-      [[nodiscard]] bool configured() const  { return data_ != nullptr; }
+      [[nodiscard]] bool double_buffered() const { return double_buffered_; }
 
-      /* data buffer, mulit-dim array shape and sizes*/
+      [[nodiscard]] bool configured() const  { return frames_ != nullptr; }
+
+      /* data buffer of the `num_frames` frames, oldest first, and the multi-dim array shape and sizes */
       const dtype *data() const {
         if (!configured())
           throw EnvironmentException("GridObservation was not configured.");
-        return data_;
+        return frames_.get() + head_ * _frame_length();
+      }
+
+      /**
+       * the buffer that data() points into. Views of the data hold on to it,
+       * so that they stay valid when this observation is reconfigured or
+       * destroyed (which gives it a new buffer), until the views are gone
+       */
+      [[nodiscard]] std::shared_ptr<const dtype[]> buffer() const {
+        if (!configured())
+          throw EnvironmentException("GridObservation was not configured.");
+        return frames_;
       }
 
       [[nodiscard]] const Shape &shape() const {
@@ -87,43 +121,63 @@ namespace agario::env {
         return strides_;
       }
 
-      /* adds a single frame to the observation at index `frame_index` */
-      void add_frame(const Player &player, const GameState &game_state, int frame_index) {
-        if (data_ == nullptr)
+      /**
+       * Stacks a new frame onto the observation: it becomes the newest of
+       * the `num_frames` frames and the oldest frame is dropped. Only the new
+       * frame is drawn, in place of the frame that drops out of the ring.
+       */
+      void push_frame(const Player &player, const GameState &game_state) {
+        if (!configured())
           throw EnvironmentException("GridObservation was not configured.");
+        if (num_frames() == 0) return;
 
-        int channel = channels_per_frame() * frame_index;
-        _mark_out_of_bounds(player, channel, game_state.config.arena_width, game_state.config.arena_height);
-        if (config_.observe_pellets) {
-          channel++;
-          _store_entities<Pellet>(game_state.pellets, player, channel, calc_type::at_least_); //at least one_pellet
-          channel++;
-          _store_entities<Pellet>(game_state.pellets, player, channel, calc_type::total_mass_); //total_number_of_pellets
-        }
+        int slot = (head_ + num_frames()) % ring_size_;
+        head_ = (head_ + 1) % ring_size_;
 
-        if (config_.observe_viruses) {
-          channel++;
-          _store_entities<Virus>(game_state.viruses, player, channel, calc_type::at_least_); //at least one_virus
-          channel++;
-          _store_entities<Virus>(game_state.viruses, player, channel, calc_type::total_mass_); //total_number_of_viruses
-        }
-        if (config_.observe_cells) {
-          channel++;
-          _store_entities<Cell>(player.cells, player, channel); //just one cell (agent)
-        }
-        if (config_.observe_others) {
-          channel++;
-          for (auto &pair : game_state.players) {
-            Player &other_player = *pair.second;
-            if (other_player.pid() == player.pid()) continue;
-            _store_entities<Cell>(other_player.cells, player, channel, calc_type::min_); //min_mass
-            _store_entities<Cell>(other_player.cells, player, channel+1, calc_type::max_); //max_mass
-          }
-        }
+        dtype *frame = _frame(slot);
+        std::fill(frame, frame + _frame_length(), dtype(0));
+        _draw_frame(frame, player, game_state);
+        _mirror(slot);
       }
 
+      /* adds a single frame to the observation at index `frame_index` (0 being the oldest) */
+      void add_frame(const Player &player, const GameState &game_state, int frame_index) {
+        if (!configured())
+          throw EnvironmentException("GridObservation was not configured.");
+
+        int slot = (head_ + frame_index) % ring_size_;
+        _draw_frame(_frame(slot), player, game_state);
+        _mirror(slot);
+      }
+
+      /* clears every frame, including the frame history */
       void clear_data() {
-        std::fill(data_, data_ + length(), 0);
+        std::fill(frames_.get(), frames_.get() + num_slots_ * _frame_length(), dtype(0));
+        head_ = 0;
+      }
+
+      /**
+       * Starts a new frame history, in which the frames from before the
+       * start are zero. Double buffered observations start it in the half of
+       * the ring that the last observation does not show, which is left
+       * untouched; the others are simply cleared.
+       */
+      void start_history() {
+        if (!configured())
+          throw EnvironmentException("GridObservation was not configured.");
+        if (!double_buffered_ || num_frames() == 0) {
+          clear_data();
+          return;
+        }
+
+        int start = (head_ + num_frames()) % ring_size_;
+        for (int i = 0; i < num_frames(); i++) {
+          int slot = (start + i) % ring_size_;
+          std::fill(_frame(slot), _frame(slot) + _frame_length(), dtype(0));
+          _mirror(slot);
+        }
+        // the next frame pushed is the newest of the new history
+        head_ = (start + ring_size_ - 1) % ring_size_;
       }
 
       /* full length of data array */
@@ -134,66 +188,102 @@ namespace agario::env {
       /* the number of frames captured by the observation */
       [[nodiscard]] int num_frames() const { return config_.num_frames; }
 
+      /* the newest of the observation's frames */
+      const dtype *newest_frame() const {
+        if (num_frames() == 0)
+          throw EnvironmentException("GridObservation has no frames.");
+        return data() + (num_frames() - 1) * _frame_length();
+      }
+
+      /* the number of channels in each frame */
+      [[nodiscard]] int channels_per_frame() const {
+        // the +1 is for the out-of-bounds channel
+        // Pellets: one says if there is a pellet in the cell, the other says the total pellets in the cell.
+        // Viruses: one says if there is a virus in the cell, the other says the total viruses in the cell.
+        // Observing others: one says if there is a cell in the cell, the other says the maximum in the cell.
+        return static_cast<int>(1 + config_.observe_cells + 2*config_.observe_others
+                                + 2*config_.observe_viruses + 2*config_.observe_pellets);
+      }
+
+      /* the scale that masses are divided by in compact observations */
+      [[nodiscard]] float mass_scale() const { return config_.mass_scale; }
+
+
+      /**
+       * makes this observation a deep copy of `other` (e.g. to fork an
+       * environment), reusing this observation's frames if they are the
+       * same size and no view of them is left (see buffer)
+       */
+      void copy_from(const GridObservation &other) {
+        if (&other == this) return;
+        bool reuse = frames_ != nullptr && frames_.use_count() == 1
+                     && num_slots_ * _frame_length() == other.num_slots_ * other._frame_length();
+
+        config_ = other.config_;
+        shape_ = other.shape_;
+        strides_ = other.strides_;
+        head_ = other.head_;
+        ring_size_ = other.ring_size_;
+        num_slots_ = other.num_slots_;
+        double_buffered_ = other.double_buffered_;
+
+        if (!reuse)
+          frames_ = other.frames_ ? std::shared_ptr<dtype[]>(new dtype[num_slots_ * _frame_length()]) : nullptr;
+        if (frames_)
+          std::copy(other.frames_.get(), other.frames_.get() + num_slots_ * _frame_length(), frames_.get());
+      }
 
       // no copy operations because if you're copying this object then
-      // you're probably not using it correctly
+      // you're probably not using it correctly (copy_from makes explicit copies)
       GridObservation(const GridObservation &) = delete; // no copy constructor
       GridObservation &operator=(const GridObservation &) = delete; // no copy assignments
 
-      /* move constructor */
-      GridObservation(GridObservation &&obs) noexcept :
-        data_(std::move(obs.data_)),
-        shape_(std::move(obs.shape_)),
-        strides_(std::move(obs.strides_)),
-        config_(std::move(obs.config_)) {
-        obs.data_ = nullptr;
-      };
-
-      /* move assignment */
-      GridObservation &operator=(GridObservation &&obs) noexcept {
-        data_ = std::move(obs.data_);
-        shape_ = std::move(obs.shape_);
-        strides_ = std::move(obs.strides_);
-        config_ = std::move(obs.config_);
-        obs.data_ = nullptr;
-        return *this;
-      };
-      ~GridObservation() { delete[] data_; }
+      GridObservation(GridObservation &&obs) noexcept = default;
+      GridObservation &operator=(GridObservation &&obs) noexcept = default;
 
     private:
-      dtype *data_;
+      /*
+       * The frames are a ring of `ring_size_` frames (the observed ones and,
+       * when double buffered, as many again for the next step or history to
+       * write into) laid out over `num_slots_` = ring_size_ + num_frames - 1
+       * slots: slot i and slot i + ring_size_ hold the same frame. The
+       * observed frames are therefore always contiguous, starting at slot
+       * `head_`, so they are handed out as they are rather than reordered.
+       */
+      std::shared_ptr<dtype[]> frames_;
+      int head_ = 0;      // ring slot of the oldest observed frame
+      int ring_size_ = 0;
+      int num_slots_ = 0;
+      bool double_buffered_ = false;
       Shape shape_;
       Strides strides_;
 
       /* observation configuration parameters */
       class Configuration {
       public:
+        Configuration() = default;
         Configuration(int num_frames, int grid_size,
                       bool observe_cells, bool observe_others,
-                      bool observe_viruses, bool observe_pellets) :
+                      bool observe_viruses, bool observe_pellets,
+                      float mass_scale = default_mass_scale<T>()) :
           num_frames(num_frames), grid_size(grid_size),
           observe_cells(observe_cells), observe_others(observe_others),
-          observe_pellets(observe_pellets), observe_viruses(observe_viruses) {}
-        int num_frames;
-        int grid_size;
-        bool observe_pellets;
-        bool observe_cells;
-        bool observe_viruses;
-        bool observe_others;
+          observe_pellets(observe_pellets), observe_viruses(observe_viruses),
+          mass_scale(mass_scale) {
+          if (mass_scale <= 0)
+            throw EnvironmentException("Observation mass_scale must be positive.");
+        }
+        int num_frames = 0;
+        int grid_size = 0;
+        bool observe_pellets = false;
+        bool observe_cells = false;
+        bool observe_viruses = false;
+        bool observe_others = false;
+        float mass_scale = default_mass_scale<T>(); // only used by compact dtypes
       };
 
       Configuration config_;
 
-      /* the number of channels in each frame */
-      [[nodiscard]] int channels_per_frame() const {
-        // the +1 is for the out-of-bounds channel
-        // Pellets: one says if there is a pellet in the cell, the other says the total pellets in the cell.
-        // Viruses: one says if there is a virus in the cell, the other says the total viruses in the cell.
-        // Observing others: one says if there is a cell in the cell, the other says the maximum in the cell.
-        return static_cast<int>(1 + config_.observe_cells + 2*config_.observe_others
-                                + 2*config_.observe_viruses + 2*config_.observe_pellets);
-      }
-
       /* creates the shape and strides to represent the multi-dimensional array */
       void _make_shapes() {
         int num_channels = config_.num_frames * channels_per_frame();
@@ -208,74 +298,263 @@ namespace agario::env {
         };
       }
 
-      /* stores the given entities in the data array at the given `channel` */
-      template<typename U>
-      void _store_entities(const std::vector<U> &entities, const Player &player, int channel, calc_type calc = calc_type::total_mass_) {
-        float view_size = _view_size(player);
+      /* draws the player's view of the world into the channels of `frame` */
+      void _draw_frame(dtype *frame, const Player &player, const GameState &game_state) {
+        int channel = 0;
+        View view = _view(player);
+        _mark_out_of_bounds(frame, view, game_state.config.arena_width, game_state.config.arena_height);
+        if (config_.observe_pellets) {
+          _gather_visible(game_state.pellets, game_state.pellet_index, view);
+          _rasterize(frame, view, ++channel, calc_type::at_least_); //at least one_pellet
+          _rasterize(frame, view, ++channel, calc_type::total_mass_, PELLET_MASS); //total_number_of_pellets
+        }
+
+        float mass_scale = config_.mass_scale;
+        if (config_.observe_viruses) {
+          _gather(game_state.viruses);
+          _rasterize(frame, view, ++channel, calc_type::at_least_); //at least one_virus
+          _rasterize(frame, view, ++channel, calc_type::total_mass_, mass_scale); //total_number_of_viruses
+        }
+        if (config_.observe_cells) {
+          _gather(player.cells);
+          _rasterize(frame, view, ++channel, calc_type::total_mass_, mass_scale); //just one cell (agent)
+        }
+        if (config_.observe_others) {
+          channel++;
+          _clear_gathered();
+          for (auto &pair : game_state.players) {
+            Player &other_player = *pair.second;
+            if (other_player.pid() == player.pid()) continue;
+            _gather(other_player.cells, true);
+          }
+          _rasterize(frame, view, channel, calc_type::min_, mass_scale); //min_mass
+          _rasterize(frame, view, channel+1, calc_type::max_, mass_scale); //max_mass
+        }
+      }
+
+      /* the number of grid squares in all of the channels of one frame */
+      [[nodiscard]] int _frame_length() const {
+        return channels_per_frame() * config_.grid_size * config_.grid_size;
+      }
+
+      [[nodiscard]] dtype *_frame(int slot) const { return frames_.get() + slot * _frame_length(); }
+
+      /* allocates a new, cleared ring of frames for the configuration, leaving the old one to any views of it */
+      void _allocate_frames() {
+        ring_size_ = double_buffered_ ? 2 * config_.num_frames : config_.num_frames;
+        num_slots_ = std::max(ring_size_ + config_.num_frames - 1, 0);
+
+        frames_ = std::shared_ptr<dtype[]>(new dtype[num_slots_ * _frame_length()]);
+        clear_data();
+      }
+
+      /* copies the frame in ring `slot` to its second slot, if it has one */
+      void _mirror(int slot) {
+        if (slot + ring_size_ < num_slots_)
+          std::copy(_frame(slot), _frame(slot) + _frame_length(), _frame(slot + ring_size_));
+      }
+
+      /* the player-centered window of the world that a frame shows */
+      struct View {
+        Location center;  // the player's center of mass
+        float size;       // width (and height) of the window, in world units
+      };
+
+      /* the view of `player`, computed once per frame rather than once per entity */
+      View _view(const Player &player) const {
+        return {player.location(), _view_size(player)};
+      }
+
+      /*
+       * Entities are rasterized in two passes over flat arrays: the positions
+       * and masses of the entities to store are gathered into `xs_`, `ys_` and
+       * `masses_`, then transformed to grid squares in one branch-free loop
+       * (which the compiler vectorizes) and finally accumulated into a channel
+       * by a loop specialized for each calc_type.
+       */
+      std::vector<float> xs_, ys_, masses_;
+      std::vector<int> squares_; // index of each gathered entity's grid square in a channel, or -1
+      std::vector<float> sums_;  // per grid square accumulators for compact dtypes
+
+      void _clear_gathered() {
+        xs_.clear();
+        ys_.clear();
+        masses_.clear();
+      }
 
-        int grid_x, grid_y;
+      /* gathers all of `entities` (appending to those already gathered if `append`) */
+      template<typename Entities>
+      void _gather(const Entities &entities, bool append = false) {
+        if (!append) _clear_gathered();
         for (auto &entity : entities) {
-          _world_to_grid(player, entity.location(), view_size, grid_x, grid_y);
-
-          int index = _index(channel, grid_x, grid_y);
-          if (_inside_grid(grid_x, grid_y)) {
-             if(calc == calc_type::at_least_)
-              data_[index] = entity.mass();
-             else if(calc == calc_type::total_mass_)
-              data_[index] += entity.mass();
-             else if(calc == calc_type::max_)
-                data_[index] = std::max(static_cast<int>(data_[index]), static_cast<int>(entity.mass()));
-             else
-                data_[index] = (data_[index] == 0 ? static_cast<int>(entity.mass()) : std::min(static_cast<int>(data_[index]), static_cast<int>(entity.mass())));
+          xs_.push_back(entity.x);
+          ys_.push_back(entity.y);
+          masses_.push_back(entity.mass());
         }
       }
-    }
 
-      /* marks out-of-bounds locations on the given `channel` */
-      void _mark_out_of_bounds(const Player &player, int channel,
-                               agario::distance arena_width, agario::distance arena_height) {
-        float view_size = _view_size(player);
+      /**
+       * gathers only the entities that `index` finds in the view, so that the
+       * cost scales with what the player can see rather than with the whole arena
+       */
+      template<typename Store>
+      void _gather_visible(const Store &store, const SpatialHash &index, const View &view) {
+        _clear_gathered();
+        // grid coordinates are truncated toward zero, so the first grid square
+        // also takes in entities up to one square beyond the view's lower edge
+        float reach = view.size / 2 + view.size / config_.grid_size;
+        index.for_each_in(view.center.x - reach, view.center.y - reach,
+                          view.center.x + reach, view.center.y + reach,
+                          [&](int id) {
+                            xs_.push_back(store.x(id));
+                            ys_.push_back(store.y(id));
+                            masses_.push_back(store.mass(id));
+                          });
+      }
 
-        int centering = config_.grid_size / 2;
-        for (int i = 0; i < config_.grid_size; i++)
-          for (int j = 0; j < config_.grid_size; j++) {
+      /**
+       * accumulates the gathered entities into `channel` of `frame`. In
+       * compact observations, the accumulated masses are divided by `scale`
+       */
+      void _rasterize(dtype *frame, const View &view, int channel, calc_type calc, float scale = 1) {
+        _grid_squares(view);
+        dtype *data = frame + _index(channel, 0, 0);
+        switch (calc) {
+          case calc_type::at_least_: _accumulate<calc_type::at_least_>(data, scale); break;
+          case calc_type::total_mass_: _accumulate<calc_type::total_mass_>(data, scale); break;
+          case calc_type::min_: _accumulate<calc_type::min_>(data, scale); break;
+          case calc_type::max_: _accumulate<calc_type::max_>(data, scale); break;
+        }
+      }
 
-            auto loc = _grid_to_world(player, view_size, i, j);
-            int index = _index(channel, i, j);
-            bool in_bounds = _in_bounds(loc, arena_width, arena_height);
-            data_[index] = in_bounds ? 0 : -1;
-          }
+      /* the grid square of each gathered entity, or -1 for those outside of the grid */
+      void _grid_squares(const View &view) {
+        int n = static_cast<int>(xs_.size());
+        squares_.resize(n);
+
+        const int grid_size = config_.grid_size;
+        const float size = static_cast<float>(grid_size);
+        const float centering = grid_size / 2.0;
+        const float center_x = view.center.x, center_y = view.center.y, view_size = view.size;
+        const float *xs = xs_.data(), *ys = ys_.data();
+        int *squares = squares_.data();
+
+        for (int k = 0; k < n; k++) {
+          int grid_x = static_cast<int>(size * (xs[k] - center_x) / view_size + centering);
+          int grid_y = static_cast<int>(size * (ys[k] - center_y) / view_size + centering);
+          bool inside = 0 <= grid_x && grid_x < grid_size && 0 <= grid_y && grid_y < grid_size;
+          squares[k] = inside ? grid_x * grid_size + grid_y : -1;
+        }
       }
 
-      /* determines what the view size should be, based on the player's mass */
-      float _view_size(const Player &player) const {
-        // todo: make this "consistent" with the renderer's view (somewhat tough)
-        return agario::clamp<float>(2 * player.mass(), 100, 300);
+      template<calc_type calc>
+      void _accumulate(dtype *data, float scale) {
+        if constexpr (is_compact<dtype>) {
+          _accumulate_quantized<calc>(data, scale);
+        } else {
+          static_cast<void>(scale); // raw masses aren't scaled
+          int n = static_cast<int>(squares_.size());
+          for (int k = 0; k < n; k++) {
+            int square = squares_[k];
+            if (square < 0) continue;
+
+            float mass = masses_[k];
+            if constexpr (calc == calc_type::at_least_)
+              data[square] = mass;
+            else if constexpr (calc == calc_type::total_mass_)
+              data[square] += mass;
+            else if constexpr (calc == calc_type::max_)
+              data[square] = std::max(static_cast<int>(data[square]), static_cast<int>(mass));
+            else
+              data[square] = (data[square] == 0 ? static_cast<int>(mass) : std::min(static_cast<int>(data[square]), static_cast<int>(mass)));
+          }
+        }
       }
 
-      /* converts world-coordinates to grid-coordinates */
-      void _world_to_grid(const Player &player, const Location &loc,
-                          float view_size, int &grid_x, int &grid_y) const {
+      /**
+       * accumulates into a compact channel: "at least one" channels become
+       * masks, and the other channels are accumulated in floats and then
+       * quantized once per grid square that an entity touched
+       */
+      template<calc_type calc>
+      void _accumulate_quantized(dtype *data, float scale) {
+        int n = static_cast<int>(squares_.size());
+        if constexpr (calc == calc_type::at_least_) {
+          for (int k = 0; k < n; k++)
+            if (squares_[k] >= 0) data[squares_[k]] = 1;
+          return;
+        }
 
-        float centering = config_.grid_size / 2.0;
+        sums_.resize(config_.grid_size * config_.grid_size);
+        for (int k = 0; k < n; k++)
+          if (squares_[k] >= 0) sums_[squares_[k]] = 0;
+
+        for (int k = 0; k < n; k++) {
+          int square = squares_[k];
+          if (square < 0) continue;
+
+          float mass = masses_[k];
+          float &sum = sums_[square];
+          if constexpr (calc == calc_type::total_mass_)
+            sum += mass;
+          else if constexpr (calc == calc_type::max_)
+            sum = std::max(sum, mass);
+          else
+            sum = (sum == 0 ? mass : std::min(sum, mass));
+        }
+
+        for (int k = 0; k < n; k++)
+          if (squares_[k] >= 0) data[squares_[k]] = quantize<dtype>(sums_[squares_[k]], scale);
+      }
 
-        auto diff_x = loc.x - player.x();
-        auto diff_y = loc.y - player.y();
+      /**
+       * marks out-of-bounds locations on the first channel of `frame`. Whether a grid
+       * square is in bounds depends on its row's x and its column's y alone,
+       * and the in-bounds columns are contiguous, so each row is filled as
+       * (at most) three spans
+       */
+      void _mark_out_of_bounds(dtype *frame, const View &view,
+                               agario::distance arena_width, agario::distance arena_height) {
+        int grid_size = config_.grid_size;
+        const dtype out_of_bounds = out_of_bounds_value<dtype>();
+
+        int first = grid_size, last = grid_size; // in-bounds columns: [first, last)
+        for (int j = 0; j < grid_size; j++) {
+          auto y = _grid_to_world(view, 0, j).y;
+          bool in_bounds = 0 <= y && y < arena_height;
+          if (in_bounds && first == grid_size) first = j;
+          if (!in_bounds && first != grid_size && last == grid_size) last = j;
+        }
 
-        grid_x = static_cast<int>(config_.grid_size * diff_x / view_size + centering);
-        grid_y = static_cast<int>(config_.grid_size * diff_y / view_size + centering);
+        for (int i = 0; i < grid_size; i++) {
+          dtype *row = frame + _index(0, i, 0);
+          auto x = _grid_to_world(view, i, 0).x;
+          if (0 <= x && x < arena_width) {
+            std::fill(row, row + first, out_of_bounds);
+            std::fill(row + first, row + last, dtype(0));
+            std::fill(row + last, row + grid_size, out_of_bounds);
+          } else {
+            std::fill(row, row + grid_size, out_of_bounds);
+          }
+        }
+      }
+
+      /* determines what the view size should be, based on the player's mass */
+      float _view_size(const Player &player) const {
+        // todo: make this "consistent" with the renderer's view (somewhat tough)
+        return agario::clamp<float>(2 * player.mass(), 100, 300);
       }
 
       /* converts grid-coordinates to world-coordinates */
-      Location _grid_to_world(const Player &player, float view_size, int grid_x, int grid_y) const {
+      Location _grid_to_world(const View &view, int grid_x, int grid_y) const {
         float centering = config_.grid_size / 2.0;
 
         float x_diff = static_cast<float>(grid_x) - centering;
         float y_diff = static_cast<float>(grid_y) - centering;
 
-        float dx = x_diff * view_size / config_.grid_size;
-        float dy = y_diff * view_size / config_.grid_size;
-        return player.location() + Location(dx, dy);
+        float dx = x_diff * view.size / config_.grid_size;
+        float dy = y_diff * view.size / config_.grid_size;
+        return view.center + Location(dx, dy);
       }
 
       /* the index of a given channel, x, y grid-coordinate in the `_data` array */
@@ -285,15 +564,6 @@ namespace agario::env {
         int y_stride = 1;
         return channel_stride * channel + x_stride * grid_x + y_stride * grid_y;
       }
-
-      /* determines whether the given x, y grid-coordinates, are within the grid */
-      [[nodiscard]] bool _inside_grid(int grid_x, int grid_y) const {
-        return 0 <= grid_x && grid_x < config_.grid_size && 0 <= grid_y && grid_y < config_.grid_size;
-      }
-
-      bool _in_bounds(const Location &loc, distance arena_width, distance arena_height) {
-        return 0 <= loc.x && loc.x < arena_width && 0 <= loc.y && loc.y < arena_height;
-      }
     };
 
     class FrameObservation {
@@ -384,11 +654,30 @@ namespace agario::env {
       /* Configures the observation types that will be returned. */
       template <typename ...Config>
       void configure_observation(Config&&... config) {
+        if (log_)
+          throw EnvironmentException("Observations can't be reconfigured while they are logged.");
+
         observations.clear();
-        for (int i = 0; i < this->num_agents(); i++)
+        for (int i = 0; i < this->num_agents(); i++) {
           observations.emplace_back(config...);
+          observations.back().set_double_buffered(double_buffered_);
+        }
       }
 
+      /**
+       * Double buffers the observations, so that the data of each observation
+       * stays untouched for one more step after it was returned. This allows
+       * it to be handed out without copying: a step writes its frame into a
+       * spare frame of the observation's ring (see GridObservation).
+       */
+      void set_double_buffered(bool double_buffered) {
+        double_buffered_ = double_buffered;
+        for (auto &observation : observations)
+          observation.set_double_buffered(double_buffered);
+      }
+
+      [[nodiscard]] bool double_buffered() const { return double_buffered_; }
+
       /* the shape of the observation object(s) */
       const typename Observation::Shape &observation_shape() const {
         assert (observations.size() > 0);
@@ -402,14 +691,73 @@ namespace agario::env {
        */
       const std::vector<Observation> &get_observations() const { return observations; }
 
-      /* since we reuse the observation's data buffer for each step,
-       * we need to have the data cleared at the beginning of each step */
-      void _step_hook() override {
+      /* starts the frame history of every observation afresh (older frames are zero) */
+      void reset() override {
         for (auto &observation : observations)
-          observation.clear_data();
+          observation.start_history();
+        episode_start_ = true;
+        Super::reset();
+        episode_start_ = false;
+      }
+
+      /**
+       * Logs the newest frame of every agent's observation to `filename`,
+       * after each reset and step, until stop_logging is called. Frames are
+       * delta encoded, with a keyframe at least every `keyframe_interval`
+       * frames (see observation_log.hpp). Replaces any log that was open.
+       */
+      void log_observations(const std::string &filename, int keyframe_interval = 100) {
+        if (observations.empty())
+          throw EnvironmentException("Observations must be configured before they are logged.");
+
+        auto &observation = observations.front();
+        int height = std::get<1>(observation.shape()), width = std::get<2>(observation.shape());
+        log_.reset(); // closes the previous log before opening the next (which may be the same file)
+        log_ = std::make_unique<ObservationLogWriter<T>>(filename, observation.channels_per_frame(),
+                                                         height, width, keyframe_interval);
+      }
+
+      /**
+       * Makes this environment an exact copy of `other`, e.g. to branch a
+       * game for tree search: its game and number of threads (see
+       * Engine::copy_state_from), agents and observations. This
+       * environment's storage is reused, so forking repeatedly into the same
+       * environment is cheap. Observation logging is not copied. Both must
+       * have the same number of agents, ticks per step and game configuration.
+       */
+      void copy_state_from(const GridEnvironment &other) {
+        if (&other == this) return;
+        Super::copy_state_from(other);
+
+        observations.resize(other.observations.size());
+        for (std::size_t i = 0; i < observations.size(); i++)
+          observations[i].copy_from(other.observations[i]);
+        double_buffered_ = other.double_buffered_;
+        episode_start_ = other.episode_start_;
+        last_player = other.last_player ? &this->engine_.player(other.last_player->pid()) : nullptr;
+      }
+
+      /* a new environment that is a copy of this one (see copy_state_from) */
+      std::unique_ptr<GridEnvironment> clone() const {
+        auto &config = this->engine_.get_game_state().config;
+        auto env = std::make_unique<GridEnvironment>(this->num_agents(), this->ticks_per_step(),
+                                                     static_cast<int>(config.arena_width), config.pellet_regen,
+                                                     config.target_num_pellets, config.target_num_viruses,
+                                                     this->num_bots_, this->reward_type_, this->c_death_,
+                                                     this->engine_.mode_number);
+        env->copy_state_from(*this);
+        return env;
       }
 
-      /* allows for intermediate grid frames to be stored in the GridObservation */
+      /* closes the observation log, if one is open */
+      void stop_logging() { log_.reset(); }
+
+      [[nodiscard]] bool logging() const { return log_ != nullptr; }
+
+      /**
+       * stacks the frame at the end of a step onto the agent's observation,
+       * which holds the frames of the last `num_frames` steps
+       */
       void _partial_observation(int agent_index, int tick_index) override {
 
         assert(agent_index < this->num_agents());
@@ -419,17 +767,11 @@ namespace agario::env {
           this-> c_death_ = 0;
 
           Observation &observation = observations[agent_index];
-
-
-          auto &state = this->engine_.game_state();
-          // we store in the observation the last `num_frames` frames between each step
-          int frame_index = tick_index - (this->ticks_per_step() - observation.num_frames());
-          if (frame_index >= 0) // frame skipping
-            observation.add_frame(player, state, frame_index);
-
+          observation.push_frame(player, this->engine_.game_state());
+          if (log_)
+            log_->write(agent_index, observation.newest_frame(), episode_start_);
 
         last_player = &player;
-        last_frame_index = frame_index;
       }
       void render() override {
 #ifdef RENDERABLE
@@ -485,8 +827,10 @@ namespace agario::env {
 
     private:
       std::vector<Observation> observations;
+      bool double_buffered_ = false;
       FrameObservation frame_observation;
-      int last_frame_index = 0;  // Store the last frame index
+      std::unique_ptr<ObservationLogWriter<T>> log_;
+      bool episode_start_ = false; // whether observations are of the start of an episode
       Player* last_player = nullptr;  // Store the last processed player
 
 #ifdef RENDERABLE
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "environment/envs/BaseEnvironment.hpp"
+#include "environment/envs/replay_log.hpp"
+
+namespace agario::env {
+
+  /* the outcome of replaying a log (see ReplayEnvironment::replay) */
+  struct ReplayStats {
+    long steps = 0;
+    long ticks = 0;
+    long resets = 0;
+    long hashes_checked = 0;
+    long diverged_step = -1; // steps into the replay at which a hash first differed (-1 if none did)
+    double seconds = 0;      // wall time spent replaying
+
+    [[nodiscard]] bool diverged() const { return diverged_step >= 0; }
+    [[nodiscard]] double ticks_per_second() const { return seconds > 0 ? ticks / seconds : 0; }
+  };
+
+  /**
+   * Re-runs the game recorded in a replay log (see
+   * BaseEnvironment::record_replay), headless and without observations, as
+   * fast as the engine can tick. Replays follow the game logic of
+   * BaseEnvironment, which the grid and GoBigger environments use unchanged.
+   */
+  class ReplayEnvironment : public BaseEnvironment<false> {
+    using Super = BaseEnvironment<false>;
+
+  public:
+    explicit ReplayEnvironment(const ReplayHeader &header) :
+      Super(header.num_agents, header.ticks_per_step, header.arena_size, header.pellet_regen,
+            header.num_pellets, header.num_viruses, header.num_bots, header.reward_type,
+            header.c_death, header.mode_number) {
+      seed_ = header.seed;
+      engine_.set_regen_budget(header.regen_budget);
+      engine_.set_low_discrepancy_spawns(header.low_discrepancy_spawns != 0);
+      engine_.set_num_threads(header.num_threads);
+    }
+
+    /**
+     * replays the log `filename`, checking the game against each of its
+     * hashes. Stops at the first hash that differs unless `keep_going`.
+     */
+    static ReplayStats replay(const std::string &filename, bool keep_going = false) {
+      ReplayLogReader log(filename);
+      ReplayEnvironment env(log.header());
+
+      ReplayStats stats;
+      ReplayLogReader::Event event{};
+      auto start = std::chrono::steady_clock::now();
+      while (log.next(event)) {
+        switch (event.kind) {
+          case ReplayEvent::reset:
+            env.engine_.state.rng.set_state(event.rng_state);
+            env.reset();
+            stats.resets++;
+            break;
+          case ReplayEvent::action:
+            env.take_action(event.pid, event.dx, event.dy, event.action);
+            break;
+          case ReplayEvent::step:
+            env.step();
+            stats.steps++;
+            break;
+          case ReplayEvent::hash:
+            stats.hashes_checked++;
+            if (env.engine_.state_hash() != event.state_hash && !stats.diverged())
+              stats.diverged_step = stats.steps;
+            break;
+        }
+        if (stats.diverged() && !keep_going) break;
+      }
+      stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      stats.ticks = stats.steps * env.ticks_per_step();
+      return stats;
+    }
+  };
+
+}
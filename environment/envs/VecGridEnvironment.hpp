@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "environment/envs/GridEnvironment.hpp"
+#include <utils/thread-pool.h>
+
+namespace agario::env {
+
+  /**
+   * A batch of independent, single-agent GridEnvironments that are stepped
+   * together, spread across a pool of worker threads. Actions for the whole
+   * batch come in as one (N, 3) array of (dx, dy, action) rows and the
+   * observations of every environment are written into one preallocated
+   * (N, C, H, W) buffer, so that a full batch crosses the Python boundary in
+   * a single call. Environments whose episode ended are reset automatically
+   * at the end of the step; the last observation of the finished episode is
+   * kept in `final_observations()`.
+   *
+   * The batch buffers are double buffered, alternating between steps, so
+   * that the observations of one step stay untouched through the following
+   * step. They are shared (see observation_buffer) so that zero-copy views
+   * of them may outlive reconfiguring, or destroying, the environment.
+   */
+  template<typename T, bool renderable>
+  class VecGridEnvironment {
+    using Environment = GridEnvironment<T, renderable>;
+
+  public:
+    using dtype = T;
+    using Shape = std::tuple<int, int, int, int>;
+    using Buffer = std::shared_ptr<const std::vector<dtype>>;
+
+    /**
+     * @param num_envs number of environments in the batch
+     * @param num_threads number of worker threads to step them with (<= 1 steps them inline)
+     * @param max_steps number of steps after which an episode is truncated (0 for no limit)
+     * the remaining parameters are those of each GridEnvironment
+     */
+    explicit VecGridEnvironment(int num_envs, int num_threads, int ticks_per_step, int arena_size,
+                                bool pellet_regen, int num_pellets, int num_viruses, int num_bots,
+                                int reward_type = 0, int c_death = 0, int mode_number = 0,
+                                int max_steps = 0) :
+      max_steps_(max_steps),
+      rewards_(_checked_num_envs(num_envs), 0), // the first member sized by num_envs
+      dones_(num_envs, false),
+      truncations_(num_envs, false),
+      steps_(num_envs, 0) {
+
+      envs_.reserve(num_envs);
+      for (int i = 0; i < num_envs; i++)
+        envs_.emplace_back(std::make_unique<Environment>(1, ticks_per_step, arena_size, pellet_regen,
+                                                         num_pellets, num_viruses, num_bots,
+                                                         reward_type, c_death, mode_number));
+
+      num_threads_ = std::clamp(num_threads, 1, num_envs);
+      if (num_threads_ > 1)
+        pool_ = std::make_unique<ThreadPool>(num_threads_);
+    }
+
+    [[nodiscard]] int num_envs() const { return static_cast<int>(envs_.size()); }
+    [[nodiscard]] int num_threads() const { return num_threads_; }
+
+    /* configures the observations of every environment, and the batch buffers to match */
+    template <typename ...Config>
+    void configure_observation(Config&&... config) {
+      for (auto &env : envs_)
+        env->configure_observation(config...);
+
+      // fresh buffers, leaving any old ones to the views that still hold them
+      observation_length_ = _observation(0).length();
+      for (int b = 0; b < 2; b++) {
+        observations_[b] = std::make_shared<std::vector<dtype>>(num_envs() * observation_length_, dtype(0));
+        final_observations_[b] = std::make_shared<std::vector<dtype>>(num_envs() * observation_length_, dtype(0));
+      }
+      for (int i = 0; i < num_envs(); i++)
+        _copy_observation(i, observations_[current_]);
+    }
+
+    /* the shape of the batched observation: (N, C, H, W) */
+    [[nodiscard]] Shape observation_shape() const {
+      if (!observations_[current_])
+        throw EnvironmentException("VecGridEnvironment observation was not configured.");
+
+      auto [channels, height, width] = _observation(0).shape();
+      return {num_envs(), channels, height, width};
+    }
+
+    /* configures the regeneration of every environment (see BaseEnvironment::configure_regen) */
+    void configure_regen(int budget, bool low_discrepancy = false) {
+      for (auto &env : envs_)
+        env->configure_regen(budget, low_discrepancy);
+    }
+
+    /* seeds environment i with `seed + i` */
+    void seed(int seed) {
+      for (int i = 0; i < num_envs(); i++)
+        envs_[i]->seed(seed + i);
+    }
+
+    /* resets every environment in the batch */
+    void reset() {
+      current_ ^= 1;
+      _for_each_env([this](int i) {
+        envs_[i]->reset();
+        steps_[i] = 0;
+        dones_[i] = truncations_[i] = false;
+        _copy_observation(i, observations_[current_]);
+      });
+    }
+
+    /**
+     * Takes one action in, and steps, every environment in the batch.
+     * @param actions row-major (N, 3) array where row i holds the (dx, dy, action)
+     * for environment i, as in BaseEnvironment::take_action
+     */
+    void step(const float *actions) {
+      current_ ^= 1;
+      _for_each_env([this, actions](int i) {
+        auto &env = *envs_[i];
+        const float *action = actions + 3 * i;
+        env.take_actions({Action(action[0], action[1], static_cast<agario::action>(action[2]))});
+
+        rewards_[i] = env.step().front();
+        steps_[i]++;
+        dones_[i] = env.dones().front();
+        truncations_[i] = !dones_[i] && max_steps_ > 0 && steps_[i] >= max_steps_;
+        _copy_observation(i, observations_[current_]);
+
+        if (dones_[i] || truncations_[i]) {
+          _copy_observation(i, final_observations_[current_]);
+          env.reset();
+          steps_[i] = 0;
+          _copy_observation(i, observations_[current_]);
+        }
+      });
+    }
+
+    /* (N, C, H, W) observations of the batch as of the last step or reset */
+    [[nodiscard]] const dtype *observations() const { return observation_buffer()->data(); }
+
+    /* final observations of the episodes that ended on the last step (where dones or truncations are set) */
+    [[nodiscard]] const dtype *final_observations() const { return final_observation_buffer()->data(); }
+
+    /* the buffers holding observations() and final_observations(), shared with the caller */
+    [[nodiscard]] Buffer observation_buffer() const { return _configured(observations_[current_]); }
+    [[nodiscard]] Buffer final_observation_buffer() const { return _configured(final_observations_[current_]); }
+
+    [[nodiscard]] const std::vector<reward> &rewards() const { return rewards_; }
+    [[nodiscard]] const std::vector<std::uint8_t> &dones() const { return dones_; }
+    [[nodiscard]] const std::vector<std::uint8_t> &truncations() const { return truncations_; }
+
+    /**
+     * tick profile of the whole batch: the profiles of all of the environments
+     * summed key by key (empty unless built with AGARIO_PROFILE)
+     */
+    [[nodiscard]] std::map<std::string, double> profile() const {
+      std::map<std::string, double> total;
+      for (auto &env : envs_)
+        for (auto &[key, value] : env->profile())
+          total[key] += value;
+      return total;
+    }
+
+    void reset_profile() {
+      for (auto &env : envs_)
+        env->reset_profile();
+    }
+
+    /* direct access to the environments in the batch */
+    Environment &env(int i) { return *envs_.at(i); }
+
+    VecGridEnvironment(const VecGridEnvironment &) = delete;
+    VecGridEnvironment &operator=(const VecGridEnvironment &) = delete;
+
+  private:
+    std::vector<std::unique_ptr<Environment>> envs_;
+    std::unique_ptr<ThreadPool> pool_;
+    int num_threads_;
+    const int max_steps_;
+
+    int observation_length_ = 0;
+    std::array<std::shared_ptr<std::vector<dtype>>, 2> observations_;
+    std::array<std::shared_ptr<std::vector<dtype>>, 2> final_observations_;
+    int current_ = 0; // which of the two buffers holds the last step's observations
+
+    // one byte per environment (not vector<bool>) so that workers can write them concurrently
+    std::vector<reward> rewards_;
+    std::vector<std::uint8_t> dones_;
+    std::vector<std::uint8_t> truncations_;
+    std::vector<int> steps_;
+
+    static int _checked_num_envs(int num_envs) {
+      if (num_envs <= 0)
+        throw EnvironmentException("Number of environments (" + std::to_string(num_envs) + ") must be positive");
+      return num_envs;
+    }
+
+    static Buffer _configured(const std::shared_ptr<std::vector<dtype>> &buffer) {
+      if (!buffer)
+        throw EnvironmentException("VecGridEnvironment observation was not configured.");
+      return buffer;
+    }
+
+    const typename Environment::Observation &_observation(int i) const {
+      return envs_[i]->get_observations().front();
+    }
+
+    /* copies the observation of environment `i` into its slot of `buffer` */
+    void _copy_observation(int i, const std::shared_ptr<std::vector<dtype>> &buffer) const {
+      if (!buffer) return; // not configured yet
+      const dtype *data = _observation(i).data();
+      std::copy(data, data + observation_length_, buffer->begin() + i * observation_length_);
+    }
+
+    /**
+     * Calls `f(i)` for every environment index i, splitting the environments
+     * evenly among the worker threads. Exceptions thrown by `f` are rethrown
+     * on the calling thread once every worker has finished.
+     */
+    template<typename F>
+    void _for_each_env(F &&f) {
+      if (!pool_) {
+        for (int i = 0; i < num_envs(); i++)
+          f(i);
+        return;
+      }
+
+      std::exception_ptr error;
+      std::mutex error_mutex;
+      for (int t = 0; t < num_threads_; t++) {
+        pool_->schedule([&, t]() {
+          try {
+            for (int i = t; i < num_envs(); i += num_threads_)
+              f(i);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+          }
+        });
+      }
+      pool_->wait();
+      if (error) std::rethrow_exception(error);
+    }
+  };
+
+}
@@ -0,0 +1,332 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "environment/envs/BaseEnvironment.hpp"
+#include "environment/envs/quantization.hpp"
+
+/**
+ * Delta encoding of grid observation frames, and a streaming file format for
+ * logging them (e.g. for offline RL datasets).
+ *
+ * Consecutive frames of a grid observation are mostly identical, so a frame
+ * is stored as the grid squares of each channel that changed since the
+ * previous frame of the same agent, with periodic dense keyframes from which
+ * decoding can start. The file is little-endian:
+ *
+ *   header:  char magic[4] = "AGOL", u32 version, char dtype[4] (NumPy style, e.g. "<i4"),
+ *            u32 channels, u32 height, u32 width, u32 keyframe_interval, u32 reserved
+ *   records: u8 kind (0 = keyframe, 1 = delta), u8 flags (1 = first frame of an episode),
+ *            u16 agent, u32 step (within the episode), u32 payload size (bytes), payload
+ *
+ * A keyframe's payload is the dense frame, T[channels * height * width]. A
+ * delta's payload is u32 counts[channels], then the u32 indices (within
+ * their channel) of the changed grid squares of every channel, in order,
+ * then their T values.
+ */
+namespace agario::env {
+
+  /* NumPy style name of observation type `T`, as stored in observation logs */
+  template<typename T>
+  constexpr const char *dtype_name() {
+    if constexpr (std::is_same_v<T, float16>) return "<f2";
+    else if constexpr (std::is_same_v<T, float>) return "<f4";
+    else if constexpr (std::is_same_v<T, std::uint8_t>) return "|u1";
+    else if constexpr (std::is_same_v<T, std::uint16_t>) return "<u2";
+    else if constexpr (std::is_same_v<T, std::int32_t>) return "<i4";
+    else static_assert(sizeof(T) == 0, "no dtype name for this observation type");
+  }
+
+  /* the grid squares of each channel of a frame that changed since the previous frame */
+  template<typename T>
+  struct Delta {
+    std::vector<std::uint32_t> counts;  // number of changed squares, per channel
+    std::vector<std::uint32_t> indices; // index of each changed square within its channel
+    std::vector<T> values;              // new value of each changed square
+
+    [[nodiscard]] std::size_t bytes() const {
+      return counts.size() * sizeof(std::uint32_t) + indices.size() * (sizeof(std::uint32_t) + sizeof(T));
+    }
+  };
+
+  /* encodes frames as Deltas against the frame encoded before them */
+  template<typename T>
+  class DeltaEncoder {
+  public:
+    DeltaEncoder(int channels, int channel_length) :
+      channels_(channels), channel_length_(channel_length) { }
+
+    /* whether there is a previous frame to encode against */
+    [[nodiscard]] bool has_previous() const { return !previous_.empty(); }
+
+    /* forgets the previous frame, so that the next frame must be a keyframe */
+    void reset() { previous_.clear(); }
+
+    /* makes `frame` the previous frame (e.g. after storing it as a keyframe) */
+    void set_previous(const T *frame) {
+      previous_.assign(frame, frame + channels_ * channel_length_);
+    }
+
+    /* encodes `frame` into `delta`, and makes it the previous frame */
+    void encode(const T *frame, Delta<T> &delta) {
+      if (!has_previous())
+        throw EnvironmentException("DeltaEncoder has no previous frame to encode against.");
+
+      delta.counts.assign(channels_, 0);
+      delta.indices.clear();
+      delta.values.clear();
+
+      for (int c = 0; c < channels_; c++) {
+        const T *current = frame + c * channel_length_;
+        T *previous = previous_.data() + c * channel_length_;
+        std::size_t changed_before = delta.indices.size();
+        for (int i = 0; i < channel_length_; i++) {
+          if (std::memcmp(&current[i], &previous[i], sizeof(T)) == 0) continue;
+          delta.indices.push_back(i);
+          delta.values.push_back(current[i]);
+          previous[i] = current[i];
+        }
+        delta.counts[c] = delta.indices.size() - changed_before;
+      }
+    }
+
+  private:
+    int channels_;
+    int channel_length_;
+    std::vector<T> previous_;
+  };
+
+  /* rebuilds dense frames from a keyframe and the Deltas that follow it */
+  template<typename T>
+  class DeltaDecoder {
+  public:
+    DeltaDecoder(int channels, int channel_length) :
+      channels_(channels), channel_length_(channel_length) { }
+
+    [[nodiscard]] bool has_frame() const { return !frame_.empty(); }
+
+    /* the dense frame as of the last keyframe or delta */
+    [[nodiscard]] const T *frame() const { return frame_.data(); }
+
+    void keyframe(const T *frame) {
+      frame_.assign(frame, frame + channels_ * channel_length_);
+    }
+
+    void apply(const Delta<T> &delta) {
+      if (!has_frame())
+        throw EnvironmentException("DeltaDecoder has no keyframe to apply a delta to.");
+
+      std::size_t k = 0;
+      for (int c = 0; c < channels_; c++) {
+        T *channel = frame_.data() + c * channel_length_;
+        for (std::uint32_t n = 0; n < delta.counts[c]; n++, k++)
+          channel[delta.indices[k]] = delta.values[k];
+      }
+    }
+
+  private:
+    int channels_;
+    int channel_length_;
+    std::vector<T> frame_;
+  };
+
+  /* streams the frames of one or more agents into an observation log file */
+  template<typename T>
+  class ObservationLogWriter {
+  public:
+    ObservationLogWriter(const std::string &filename, int channels, int height, int width,
+                         int keyframe_interval = 100) :
+      out_(filename, std::ios::binary), channels_(channels), channel_length_(height * width),
+      keyframe_interval_(keyframe_interval) {
+
+      if (!out_.is_open())
+        throw EnvironmentException("Failed to open " + filename + " for writing");
+      if (keyframe_interval <= 0)
+        throw EnvironmentException("Observation log keyframe interval must be positive.");
+
+      out_.write("AGOL", 4);
+      _write<std::uint32_t>(1); // version
+      char dtype[4] = {};
+      std::strncpy(dtype, dtype_name<T>(), sizeof(dtype));
+      out_.write(dtype, sizeof(dtype));
+      for (int value : {channels, height, width, keyframe_interval, 0})
+        _write<std::uint32_t>(value);
+    }
+
+    /**
+     * appends a frame of `agent`: a delta against its previous frame, or a
+     * keyframe at the start of an episode, every `keyframe_interval` frames,
+     * or whenever a delta wouldn't be smaller
+     */
+    void write(int agent, const T *frame, bool episode_start) {
+      if (agent >= static_cast<int>(streams_.size()))
+        streams_.resize(agent + 1, Stream(channels_, channel_length_));
+
+      auto &stream = streams_[agent];
+      if (episode_start) stream.step = 0;
+
+      bool keyframe = episode_start || !stream.encoder.has_previous()
+                      || stream.since_keyframe + 1 >= keyframe_interval_;
+      if (!keyframe) {
+        stream.encoder.encode(frame, delta_);
+        keyframe = delta_.bytes() >= _frame_bytes();
+      }
+
+      _write<std::uint8_t>(keyframe ? 0 : 1);
+      _write<std::uint8_t>(episode_start ? 1 : 0);
+      _write<std::uint16_t>(agent);
+      _write<std::uint32_t>(stream.step);
+
+      if (keyframe) {
+        _write<std::uint32_t>(_frame_bytes());
+        out_.write(reinterpret_cast<const char *>(frame), _frame_bytes());
+        stream.encoder.set_previous(frame);
+        stream.since_keyframe = 0;
+      } else {
+        _write<std::uint32_t>(delta_.bytes());
+        _write_all(delta_.counts);
+        _write_all(delta_.indices);
+        _write_all(delta_.values);
+        stream.since_keyframe++;
+      }
+      stream.step++;
+
+      if (!out_)
+        throw EnvironmentException("Failed to write to observation log");
+    }
+
+    void flush() { out_.flush(); }
+
+  private:
+    struct Stream {
+      Stream(int channels, int channel_length) : encoder(channels, channel_length) { }
+      DeltaEncoder<T> encoder;
+      int step = 0;
+      int since_keyframe = 0;
+    };
+
+    std::ofstream out_;
+    int channels_;
+    int channel_length_;
+    int keyframe_interval_;
+    std::vector<Stream> streams_; // one per agent
+    Delta<T> delta_;
+
+    [[nodiscard]] std::size_t _frame_bytes() const { return channels_ * channel_length_ * sizeof(T); }
+
+    template<typename U>
+    void _write(U value) { out_.write(reinterpret_cast<const char *>(&value), sizeof(U)); }
+
+    template<typename U>
+    void _write_all(const std::vector<U> &values) {
+      out_.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(U));
+    }
+  };
+
+  /* reads the frames of an observation log back, one record at a time */
+  template<typename T>
+  class ObservationLogReader {
+  public:
+    struct Record {
+      int agent;
+      int step;
+      bool episode_start;
+      bool keyframe;
+    };
+
+    explicit ObservationLogReader(const std::string &filename) : in_(filename, std::ios::binary) {
+      if (!in_.is_open())
+        throw EnvironmentException("Failed to open " + filename + " for reading");
+
+      char magic[4], dtype[4];
+      in_.read(magic, sizeof(magic));
+      auto version = _read<std::uint32_t>();
+      in_.read(dtype, sizeof(dtype));
+      if (!in_ || std::memcmp(magic, "AGOL", 4) != 0 || version != 1)
+        throw EnvironmentException(filename + " is not an observation log");
+      if (std::strncmp(dtype, dtype_name<T>(), sizeof(dtype)) != 0)
+        throw EnvironmentException(filename + " holds observations of type " + std::string(dtype, 3));
+
+      channels_ = _read<std::uint32_t>();
+      height_ = _read<std::uint32_t>();
+      width_ = _read<std::uint32_t>();
+      keyframe_interval_ = _read<std::uint32_t>();
+      _read<std::uint32_t>(); // reserved
+    }
+
+    [[nodiscard]] int channels() const { return channels_; }
+    [[nodiscard]] int height() const { return height_; }
+    [[nodiscard]] int width() const { return width_; }
+    [[nodiscard]] int keyframe_interval() const { return keyframe_interval_; }
+
+    /* reads the next record, returning false at the end of the log */
+    bool next() {
+      auto kind = _read<std::uint8_t>();
+      if (in_.eof()) return false;
+
+      record_.keyframe = kind == 0;
+      record_.episode_start = _read<std::uint8_t>() & 1;
+      record_.agent = _read<std::uint16_t>();
+      record_.step = _read<std::uint32_t>();
+      auto bytes = _read<std::uint32_t>();
+
+      if (record_.agent >= static_cast<int>(decoders_.size()))
+        decoders_.resize(record_.agent + 1, DeltaDecoder<T>(channels_, height_ * width_));
+      auto &decoder = decoders_[record_.agent];
+
+      if (record_.keyframe) {
+        buffer_.resize(channels_ * height_ * width_);
+        _read_all(buffer_, bytes);
+        decoder.keyframe(buffer_.data());
+      } else {
+        delta_.counts.resize(channels_);
+        _read_all(delta_.counts, channels_ * sizeof(std::uint32_t));
+        std::size_t changed = 0;
+        for (auto count : delta_.counts) changed += count;
+        delta_.indices.resize(changed);
+        delta_.values.resize(changed);
+        _read_all(delta_.indices, changed * sizeof(std::uint32_t));
+        _read_all(delta_.values, changed * sizeof(T));
+        decoder.apply(delta_);
+      }
+
+      if (!in_)
+        throw EnvironmentException("Observation log is truncated");
+      return true;
+    }
+
+    /* the last record that was read */
+    [[nodiscard]] const Record &record() const { return record_; }
+
+    /* the dense frame of the last record that was read */
+    [[nodiscard]] const T *frame() const { return decoders_[record_.agent].frame(); }
+
+  private:
+    std::ifstream in_;
+    int channels_, height_, width_, keyframe_interval_;
+    Record record_ = {};
+    std::vector<DeltaDecoder<T>> decoders_; // one per agent
+    std::vector<T> buffer_;
+    Delta<T> delta_;
+
+    template<typename U>
+    U _read() {
+      U value{};
+      in_.read(reinterpret_cast<char *>(&value), sizeof(U));
+      return value;
+    }
+
+    template<typename U>
+    void _read_all(std::vector<U> &values, std::size_t bytes) {
+      if (bytes != values.size() * sizeof(U))
+        throw EnvironmentException("Observation log record has an unexpected size");
+      in_.read(reinterpret_cast<char *>(values.data()), bytes);
+    }
+  };
+
+} // namespace agario::env
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include <agario/core/settings.hpp>
+
+namespace agario::env {
+
+  /**
+   * An IEEE 754 half precision number, stored as its 16 bits so that a
+   * buffer of them has the layout of a NumPy float16 array. Arithmetic is
+   * done in float; this type only converts to and from it.
+   */
+  struct float16 {
+    std::uint16_t bits = 0;
+
+    float16() = default;
+    float16(float value) : bits(_from_float(value)) {} // NOLINT: implicit like the built-in types
+
+    operator float() const { // NOLINT
+      std::uint32_t sign = static_cast<std::uint32_t>(bits & 0x8000) << 16;
+      std::uint32_t exponent = (bits >> 10) & 0x1f;
+      std::uint32_t mantissa = bits & 0x3ff;
+
+      if (exponent == 0) { // zero or subnormal
+        float value = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -value : value;
+      }
+
+      std::uint32_t word;
+      if (exponent == 0x1f) // infinity or NaN
+        word = sign | 0x7f800000 | (mantissa << 13);
+      else
+        word = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+      float value;
+      std::memcpy(&value, &word, sizeof(value));
+      return value;
+    }
+
+  private:
+    /* rounds `value` to the nearest half, ties to even */
+    static std::uint16_t _from_float(float value) {
+      std::uint32_t word;
+      std::memcpy(&word, &value, sizeof(word));
+
+      auto sign = static_cast<std::uint16_t>((word >> 16) & 0x8000);
+      std::uint32_t abs = word & 0x7fffffff;
+
+      if (abs > 0x7f800000) return sign | 0x7e00;  // NaN
+      if (abs >= 0x47800000) return sign | 0x7c00; // too large: infinity
+      if (abs < 0x33000000) return sign;           // too small: zero
+
+      if (abs < 0x38800000) { // subnormal half
+        std::uint32_t mantissa = (abs & 0x7fffff) | 0x800000;
+        int shift = 126 - static_cast<int>(abs >> 23);
+        std::uint32_t half = mantissa >> shift;
+        std::uint32_t rest = mantissa & ((1u << shift) - 1);
+        std::uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+          half++;
+        return sign | static_cast<std::uint16_t>(half);
+      }
+
+      std::uint32_t rounded = abs + 0xfff + ((abs >> 13) & 1);
+      return sign | static_cast<std::uint16_t>((rounded - 0x38000000) >> 13);
+    }
+  };
+
+  /**
+   * Whether grid observations of type `T` are "compact": narrower than the
+   * int32 default, so that their channels are quantized rather than holding
+   * raw masses. In compact observations the "at least one" channels are
+   * 0/1 masks, pellet channels hold counts and mass channels hold masses
+   * divided by a scale.
+   */
+  template<typename T>
+  constexpr bool is_compact = sizeof(T) < 4;
+
+  /* the default scale that masses are divided by in observations of type `T` */
+  template<typename T>
+  constexpr float default_mass_scale() {
+    if constexpr (std::is_same_v<T, float16>)
+      return MAX_MASS_IN_THE_GAME; // normalized to [0, 1]
+    else if constexpr (std::is_integral_v<T> && is_compact<T>)
+      return std::max<float>(1, static_cast<float>(MAX_MASS_IN_THE_GAME) / std::numeric_limits<T>::max());
+    else
+      return 1;
+  }
+
+  /* the value of out-of-bounds grid squares, which is a 1 in unsigned types */
+  template<typename T>
+  T out_of_bounds_value() {
+    if constexpr (std::is_unsigned_v<T>)
+      return 1;
+    else
+      return -1;
+  }
+
+  /**
+   * quantizes a (non-negative) `value` to type `T` after dividing it by
+   * `scale`. Integers are rounded and saturate at the type's maximum, and
+   * non-zero values never round down to zero, so that a small cell is
+   * still visible in a coarsely quantized channel.
+   */
+  template<typename T>
+  T quantize(float value, float scale) {
+    float scaled = value / scale;
+    if constexpr (std::is_integral_v<T>) {
+      if (value <= 0) return 0;
+      float maximum = static_cast<float>(std::numeric_limits<T>::max());
+      return static_cast<T>(std::min(std::max(std::round(scaled), 1.0f), maximum));
+    } else {
+      return static_cast<T>(scaled);
+    }
+  }
+
+} // namespace agario::env
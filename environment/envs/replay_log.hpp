@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Replay logs: everything needed to re-run an environment's game exactly,
+ * without any of its state. Games are deterministic given the engine's RNG
+ * state, so a log holds just the environment's configuration, the RNG state
+ * at each reset and the actions taken before each step, plus (optionally)
+ * a hash of the game every few steps to detect where a replay diverges.
+ * The file is little-endian:
+ *
+ *   header: ReplayHeader
+ *   events: u8 kind, then
+ *     reset:  u64 rng_state[4]                 (the RNG state that the reset started from)
+ *     action: u16 pid, f32 dx, f32 dy, u8 action (as passed to take_action)
+ *     step:   nothing
+ *     hash:   u64 state_hash                   (Engine::state_hash after the last step)
+ */
+namespace agario::env {
+
+  /* the configuration of the recorded environment: what was passed to its constructor, configure_regen and set_num_threads */
+  struct ReplayHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::int32_t num_agents;
+    std::int32_t ticks_per_step;
+    std::int32_t arena_size;
+    std::int32_t pellet_regen;
+    std::int32_t num_pellets;
+    std::int32_t num_viruses;
+    std::int32_t num_bots;
+    std::int32_t reward_type;
+    std::int32_t c_death;
+    std::int32_t mode_number;
+    std::int32_t seed;
+    std::uint32_t hash_interval; // steps between hash events (0 for none)
+    std::int32_t regen_budget;           // see Engine::set_regen_budget
+    std::int32_t low_discrepancy_spawns; // see Engine::set_low_discrepancy_spawns
+    std::int32_t num_threads;            // see Engine::set_num_threads (games on a pool tick in phases)
+  };
+
+  enum class ReplayEvent : std::uint8_t { reset = 0, action = 1, step = 2, hash = 3 };
+
+  class ReplayLogWriter {
+  public:
+    static constexpr char magic[4] = {'A', 'G', 'R', 'P'};
+    static constexpr std::uint32_t version = 3;
+
+    ReplayLogWriter(const std::string &filename, ReplayHeader header) : out_(filename, std::ios::binary) {
+      if (!out_.is_open())
+        throw std::runtime_error("Failed to open " + filename + " for writing");
+      std::memcpy(header.magic, magic, sizeof(magic));
+      header.version = version;
+      hash_interval_ = header.hash_interval;
+      _write(header);
+    }
+
+    /* whether the log has seen a reset (events before the first one can't be replayed, so they're dropped) */
+    [[nodiscard]] bool started() const { return started_; }
+
+    void reset(const std::array<std::uint64_t, 4> &rng_state) {
+      started_ = true;
+      steps_ = 0;
+      _write(ReplayEvent::reset);
+      _write(rng_state);
+    }
+
+    void action(std::uint16_t pid, float dx, float dy, std::uint8_t action) {
+      if (!started_) return;
+      _write(ReplayEvent::action);
+      _write(pid);
+      _write(dx);
+      _write(dy);
+      _write(action);
+    }
+
+    /* records a step, returning whether a hash of the game should follow it */
+    bool step() {
+      if (!started_) return false;
+      _write(ReplayEvent::step);
+      steps_++;
+      return hash_interval_ > 0 && steps_ % hash_interval_ == 0;
+    }
+
+    void hash(std::uint64_t state_hash) {
+      _write(ReplayEvent::hash);
+      _write(state_hash);
+    }
+
+    void flush() { out_.flush(); }
+
+  private:
+    std::ofstream out_;
+    std::uint32_t hash_interval_ = 0;
+    std::uint64_t steps_ = 0; // since the last reset
+    bool started_ = false;
+
+    template<typename T>
+    void _write(const T &value) { out_.write(reinterpret_cast<const char *>(&value), sizeof(T)); }
+  };
+
+  class ReplayLogReader {
+  public:
+    /* a single event of the log, with the fields of its kind filled in */
+    struct Event {
+      ReplayEvent kind;
+      std::array<std::uint64_t, 4> rng_state;
+      std::uint16_t pid;
+      float dx, dy;
+      std::uint8_t action;
+      std::uint64_t state_hash;
+    };
+
+    explicit ReplayLogReader(const std::string &filename) : in_(filename, std::ios::binary) {
+      if (!in_.is_open())
+        throw std::runtime_error("Failed to open " + filename + " for reading");
+
+      _read(header_);
+      if (!in_ || std::memcmp(header_.magic, ReplayLogWriter::magic, sizeof(header_.magic)) != 0)
+        throw std::runtime_error(filename + " is not a replay log");
+      if (header_.version != ReplayLogWriter::version)
+        throw std::runtime_error(filename + " is a version " + std::to_string(header_.version)
+                                 + " replay log, expected version " + std::to_string(ReplayLogWriter::version));
+    }
+
+    [[nodiscard]] const ReplayHeader &header() const { return header_; }
+
+    /* reads the next event into `event`, returning false at the end of the log */
+    bool next(Event &event) {
+      if (!_read(event.kind)) return false;
+      switch (event.kind) {
+        case ReplayEvent::reset: _read(event.rng_state); break;
+        case ReplayEvent::action:
+          _read(event.pid);
+          _read(event.dx);
+          _read(event.dy);
+          _read(event.action);
+          break;
+        case ReplayEvent::step: break;
+        case ReplayEvent::hash: _read(event.state_hash); break;
+        default: throw std::runtime_error("Replay log has an unknown event");
+      }
+      if (!in_)
+        throw std::runtime_error("Replay log is truncated");
+      return true;
+    }
+
+  private:
+    std::ifstream in_;
+    ReplayHeader header_ = {};
+
+    template<typename T>
+    bool _read(T &value) { return static_cast<bool>(in_.read(reinterpret_cast<char *>(&value), sizeof(T))); }
+  };
+
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+/* whether the environments' engines record a per-phase tick profile (see agario/utils/profiler.hpp) */
+static constexpr bool profiled =
+#ifdef AGARIO_PROFILE
+  true
+#else
+  false
+#endif
+;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <gtest/gtest.h>
+#include <filesystem>
+#include <numeric>
 #include <environment/envs/GridEnvironment.hpp>
 
 #include <environment/renderable.hpp>
@@ -83,6 +85,98 @@ namespace {
               }
   }
 
+  /* the pellets channel holds every pellet in the player's view, and nothing else */
+  TEST(GridEnvTest, ObservesPelletsInView) {
+    agario::Engine<renderable> engine(2000, 2000, 40000, 0);
+    engine.seed(0);
+    engine.reset();
+    auto &player = engine.player(engine.add_player<agario::Player<renderable>>());
+    player.cells.clear();
+    // puts the lower edges of the view on a (32 unit) bucket boundary of the pellet index
+    player.add_cell(agario::Location(1092, 1092), 100);
+
+    int grid_size = 64;
+    Observation observation(1, grid_size, false, false, false, true);
+    observation.add_frame(player, engine.game_state(), 0);
+
+    // the view is the 200 unit square centered on the player (view size is twice the mass)
+    float view_size = 200;
+    int expected = 0;
+    for (auto &pellet : engine.pellets()) {
+      auto grid_x = static_cast<int>(grid_size * (pellet.x - player.x()) / view_size + grid_size / 2.0);
+      auto grid_y = static_cast<int>(grid_size * (pellet.y - player.y()) / view_size + grid_size / 2.0);
+      if (0 <= grid_x && grid_x < grid_size && 0 <= grid_y && grid_y < grid_size)
+        expected += pellet.mass();
+    }
+
+    // channels: out-of-bounds, any pellets, total pellets
+    const dtype *totals = observation.data() + 2 * grid_size * grid_size;
+    int observed = std::accumulate(totals, totals + grid_size * grid_size, 0);
+    ASSERT_GT(expected, 0);
+    EXPECT_EQ(observed, expected);
+  }
+
+  /* float16 rounds to the nearest half precision number, saturating to infinity */
+  TEST(GridEnvTest, Float16) {
+    for (float value : {0.0f, 1.0f, -1.0f, 0.5f, 1000.0f, 65504.0f, 0.000061035156f, 0.000000059604645f})
+      EXPECT_EQ(static_cast<float>(float16(value)), value) << value << " is exact in half precision";
+
+    EXPECT_EQ(static_cast<float>(float16(1000.2f)), 1000.0f);
+    EXPECT_EQ(static_cast<float>(float16(2049.0f)), 2048.0f); // ties to even
+    EXPECT_TRUE(std::isinf(static_cast<float>(float16(70000.0f))));
+    EXPECT_EQ(float16(1e-9f).bits, 0);
+  }
+
+  /* compact observations see the same grid squares as int32 ones, with quantized values */
+  template <typename T>
+  void expect_compact_observation(agario::Engine<renderable> &engine,
+                                  const agario::Player<renderable> &player,
+                                  const std::vector<int> &expected) {
+    GridObservation<T, renderable> observation(1, 64, true, true, true, true);
+    observation.add_frame(player, engine.game_state(), 0);
+    ASSERT_EQ(observation.length(), expected.size());
+
+    int channel_length = 64 * 64;
+    float mass_scale = observation.mass_scale();
+    float maximum = std::is_integral_v<T> ? static_cast<float>(std::numeric_limits<T>::max()) : INFINITY;
+    const T *data = observation.data();
+    for (int i = 0; i < observation.length(); i++) {
+      int channel = i / channel_length;
+      auto value = static_cast<float>(data[i]);
+
+      ASSERT_EQ(value != 0, expected[i] != 0) << "channel " << channel;
+      if (channel == 0) // out-of-bounds
+        EXPECT_EQ(value, expected[i] ? static_cast<float>(out_of_bounds_value<T>()) : 0);
+      else if (channel == 1 || channel == 3) // "at least one" masks
+        EXPECT_EQ(value, expected[i] != 0);
+      else if (channel == 2) // pellet counts
+        EXPECT_EQ(value, std::min<float>(expected[i], maximum));
+      else // scaled masses, of which the int32 observation truncated any fractions
+        EXPECT_NEAR(value * mass_scale, expected[i], mass_scale / 2 + 1 + 0.001 * expected[i]) << "channel " << channel;
+    }
+  }
+
+  TEST(GridEnvTest, CompactObservations) {
+    agario::Engine<renderable> engine(1000, 1000, 5000, 20);
+    engine.seed(0);
+    engine.reset();
+    auto &player = engine.player(engine.add_player<agario::Player<renderable>>());
+    player.cells.clear();
+    player.add_cell(agario::Location(80, 500), 120);
+    for (int i = 0; i < 20; i++)
+      engine.add_player<agario::bot::HungryBot<renderable>>();
+    for (int t = 0; t < 120; t++)
+      engine.tick(agario::time_delta(1.0 / 60));
+
+    Observation reference(1, 64, true, true, true, true);
+    reference.add_frame(player, engine.game_state(), 0);
+    std::vector<int> expected(reference.data(), reference.data() + reference.length());
+
+    expect_compact_observation<std::uint16_t>(engine, player, expected);
+    expect_compact_observation<std::uint8_t>(engine, player, expected);
+    expect_compact_observation<float16>(engine, player, expected);
+  }
+
   /* ===================== Fixture Tests ===================== */
 
   class EnvTest : public testing::Test {
@@ -175,6 +269,219 @@ namespace {
     }
   }
 
+  /* a double buffered observation is left intact by the next step */
+  TEST_F(EnvTest, DoubleBuffered) {
+    SetUp();
+    env->set_double_buffered(true);
+    std::vector<Action> actions(env->num_agents(), Action(0.5, 0.5, agario::action::none));
+
+    env->take_actions(actions);
+    auto _ = env->step();
+    auto &obs = env->get_observations().front();
+
+    for (int step = 0; step < 5; step++) {
+      const dtype *previous = obs.data();
+      std::vector<dtype> copy(previous, previous + obs.length());
+
+      env->take_actions(actions);
+      _ = env->step();
+      ASSERT_NE(obs.data(), previous) << "step did not move the observation";
+      ASSERT_TRUE(std::equal(copy.begin(), copy.end(), previous)) << "previous observation was overwritten";
+    }
+
+    // the last observation of an episode is left intact by the reset that starts the next
+    const dtype *terminal = obs.data();
+    std::vector<dtype> copy(terminal, terminal + obs.length());
+    env->reset();
+    ASSERT_TRUE(std::equal(copy.begin(), copy.end(), terminal)) << "reset overwrote the last observation";
+    int frame_length = obs.length() / obs.num_frames();
+    ASSERT_TRUE(std::all_of(obs.data(), obs.data() + frame_length, [](dtype x) { return x == 0; }))
+      << "frames from before the episode are not zero";
+
+    // and its buffer outlives reallocating the observation
+    auto buffer = obs.buffer();
+    env->set_double_buffered(false);
+    env->configure_observation(1, 16, true, true, true, true);
+    ASSERT_TRUE(std::equal(copy.begin(), copy.end(), terminal)) << "a held buffer was freed";
+  }
+
+  /* the frames of an observation are those of the last `num_frames` steps, oldest first, double buffered or not */
+  TEST_F(EnvTest, FrameStack) {
+    for (bool double_buffered : {false, true}) {
+      delete env; // the previous iteration's
+      SetUp(1);
+      int num_frames = 3;
+      env->configure_observation(num_frames, 32, true, true, true, true);
+      env->set_double_buffered(double_buffered);
+
+      for (int episode = 0; episode < 2; episode++) {
+        env->reset();
+
+        auto &obs = env->get_observations().front();
+        int frame_length = obs.length() / num_frames;
+        auto newest_frame = [&]() {
+          const dtype *newest = obs.data() + (num_frames - 1) * frame_length;
+          return std::vector<dtype>(newest, newest + frame_length);
+        };
+
+        // frames from before the episode are zero
+        ASSERT_TRUE(std::all_of(obs.data(), obs.data() + 2 * frame_length, [](dtype x) { return x == 0; }));
+
+        std::vector<std::vector<dtype>> frames = {newest_frame()};
+        std::vector<Action> actions = {Action(0.5, -0.5, agario::action::none)};
+        for (int step = 0; step < 7; step++) {
+          env->take_actions(actions);
+          auto _ = env->step();
+          frames.push_back(newest_frame());
+
+          for (int f = 0; f < num_frames; f++) {
+            std::size_t age = num_frames - 1 - f; // in steps
+            if (age >= frames.size()) continue;
+            const auto &expected = frames[frames.size() - 1 - age];
+            ASSERT_TRUE(std::equal(expected.begin(), expected.end(), obs.data() + f * frame_length))
+              << "frame " << f << " at step " << step << " of episode " << episode
+              << (double_buffered ? " (double buffered)" : "");
+          }
+        }
+      }
+    }
+  }
+
+  TEST_F(EnvTest, Profile) {
+    SetUp();
+    std::vector<Action> actions(env->num_agents(), Action(0.0, 0.0, agario::action::none));
+    env->take_actions(actions);
+    auto _ = env->step();
+
+    auto profile = env->profile();
+    if (profiled) {
+      EXPECT_EQ(profile["ticks"], env->ticks_per_step());
+      env->reset_profile();
+      EXPECT_EQ(env->profile()["ticks"], 0);
+    } else {
+      EXPECT_TRUE(profile.empty());
+    }
+  }
+
+  /* asserts that two stores hold the same entities, in the same order */
+  template<typename Store>
+  void expect_same_entities(const Store &expected, const Store &actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (int i = 0; i < static_cast<int>(expected.size()); i++) {
+      ASSERT_EQ(expected.x(i), actual.x(i)) << "entity " << i;
+      ASSERT_EQ(expected.y(i), actual.y(i)) << "entity " << i;
+      ASSERT_EQ(expected.velocity(i).dx, actual.velocity(i).dx) << "entity " << i;
+      ASSERT_EQ(expected.velocity(i).dy, actual.velocity(i).dy) << "entity " << i;
+      ASSERT_EQ(expected.mass(i), actual.mass(i)) << "entity " << i;
+    }
+  }
+
+  /* a binary snapshot restores the same state as the JSON export of it */
+  TEST_F(EnvTest, SnapshotRoundTrip) {
+    SetUp();
+    env->seed(0);
+    env->reset();
+    std::vector<Action> actions(env->num_agents(), Action(0.5, -0.5, agario::action::none));
+    for (int i = 0; i < 20; i++) {
+      env->take_actions(actions);
+      env->step();
+    }
+
+    auto dir = std::filesystem::temp_directory_path();
+    auto json_file = (dir / "agarcl-test-state.json").string();
+    auto snapshot_file = (dir / "agarcl-test-state.bin").string();
+    env->save_env_state(json_file);
+    env->save_env_state(snapshot_file);
+    EXPECT_FALSE(agario::snapshot::is_snapshot(json_file));
+    EXPECT_TRUE(agario::snapshot::is_snapshot(snapshot_file));
+    EXPECT_LT(std::filesystem::file_size(snapshot_file), std::filesystem::file_size(json_file));
+
+    GridEnvironment from_json(4, 4, 1000, true, 1000, 25, 25, true, 0);
+    GridEnvironment from_snapshot(4, 4, 1000, true, 1000, 25, 25, true, 0);
+    for (auto *loaded : {&from_json, &from_snapshot})
+      loaded->configure_observation(2, 128, true, true, true, true);
+    from_json.load_env_state(json_file);
+    from_snapshot.load_env_state(snapshot_file);
+
+    auto &original = env->engine(), &json = from_json.engine(), &binary = from_snapshot.engine();
+    expect_same_entities(original.pellets(), binary.pellets());
+    expect_same_entities(original.viruses(), binary.viruses());
+    expect_same_entities(original.foods(), binary.foods());
+    expect_same_entities(json.pellets(), binary.pellets());
+    expect_same_entities(json.viruses(), binary.viruses());
+    expect_same_entities(json.foods(), binary.foods());
+    EXPECT_EQ(json.mode_number, binary.mode_number);
+
+    ASSERT_EQ(json.player_count(), binary.player_count());
+    for (auto &[pid, player] : json.players()) {
+      auto &other = binary.get_player(pid);
+      EXPECT_EQ(player->name(), other.name());
+      EXPECT_EQ(player->is_bot, other.is_bot);
+      EXPECT_EQ(player->food_eaten, other.food_eaten);
+      EXPECT_EQ(player->virus_eaten_ticks, other.virus_eaten_ticks);
+      ASSERT_EQ(player->cells.size(), other.cells.size());
+      for (unsigned c = 0; c < player->cells.size(); c++) {
+        EXPECT_EQ(player->cells[c].id, other.cells[c].id);
+        EXPECT_EQ(player->cells[c].x, other.cells[c].x);
+        EXPECT_EQ(player->cells[c].y, other.cells[c].y);
+        EXPECT_EQ(player->cells[c].mass(), other.cells[c].mass());
+      }
+    }
+
+    // and both go on to play out the same game
+    std::vector<Action> loaded_actions(from_json.num_agents(), Action(0.5, -0.5, agario::action::none));
+    for (int i = 0; i < 10; i++) {
+      from_json.take_actions(loaded_actions);
+      from_snapshot.take_actions(loaded_actions);
+      EXPECT_EQ(from_json.step(), from_snapshot.step());
+    }
+    expect_same_entities(from_json.engine().pellets(), from_snapshot.engine().pellets());
+
+    std::filesystem::remove(json_file);
+    std::filesystem::remove(snapshot_file);
+  }
+
+  /* a cloned environment steps exactly as the original does, and can be copied back into it */
+  TEST_F(EnvTest, Clone) {
+    SetUp();
+    env->seed(0);
+    env->reset();
+    std::vector<Action> actions(env->num_agents(), Action(0.5, -0.5, agario::action::none));
+    for (int i = 0; i < 10; i++) {
+      env->take_actions(actions);
+      env->step();
+    }
+
+    auto same_observations = [](const GridEnvironment &a, const GridEnvironment &b) {
+      for (int i = 0; i < a.num_agents(); i++) {
+        auto &obs = a.get_observations()[i], &other = b.get_observations()[i];
+        if (!std::equal(obs.data(), obs.data() + obs.length(), other.data())) return false;
+      }
+      return true;
+    };
+
+    auto fork = env->clone();
+    EXPECT_TRUE(same_observations(*env, *fork));
+    for (int i = 0; i < 10; i++) {
+      env->take_actions(actions);
+      fork->take_actions(actions);
+      ASSERT_EQ(env->step(), fork->step()) << "step " << i;
+    }
+    EXPECT_TRUE(same_observations(*env, *fork));
+    EXPECT_EQ(env->dones(), fork->dones());
+
+    // branch the fork off differently, then bring it back to the original
+    std::vector<Action> other_actions(env->num_agents(), Action(-1, 1, agario::action::split));
+    fork->take_actions(other_actions);
+    fork->step();
+    EXPECT_FALSE(same_observations(*env, *fork));
+    fork->copy_state_from(*env);
+    EXPECT_TRUE(same_observations(*env, *fork));
+    env->take_actions(actions);
+    fork->take_actions(actions);
+    EXPECT_EQ(env->step(), fork->step());
+  }
+
   /* ===================== Rendering Tests ===================== */
   TEST_F(EnvTest, Render) {
     SetUp();
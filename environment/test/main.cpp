@@ -2,6 +2,9 @@
 
 #include <environment/test/grid-env-test.hpp>
 #include <environment/test/ram-env-test.hpp>
+#include <environment/test/vec-env-test.hpp>
+#include <environment/test/observation-log-test.hpp>
+#include <environment/test/replay-test.hpp>
 
 namespace { }
 
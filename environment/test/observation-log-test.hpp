@@ -0,0 +1,108 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <environment/envs/GridEnvironment.hpp>
+#include <environment/envs/observation_log.hpp>
+
+#include <environment/renderable.hpp>
+
+using namespace agario::env;
+
+namespace {
+
+  std::string log_file() {
+    return (std::filesystem::temp_directory_path() / "agarcl-test-observations.agol").string();
+  }
+
+  /* deltas hold just the changed squares of each channel, and decode back into the frame */
+  TEST(ObservationLogTest, DeltaRoundTrip) {
+    int channels = 3, channel_length = 100;
+    std::vector<int> frame(channels * channel_length, 0);
+    DeltaEncoder<int> encoder(channels, channel_length);
+    DeltaDecoder<int> decoder(channels, channel_length);
+    encoder.set_previous(frame.data());
+    decoder.keyframe(frame.data());
+
+    Delta<int> delta;
+    for (int step = 1; step <= 10; step++) {
+      frame[step] = step;                        // channel 0
+      frame[2 * channel_length + 5 * step] = -1; // channel 2
+
+      encoder.encode(frame.data(), delta);
+      ASSERT_EQ(delta.counts, (std::vector<std::uint32_t>{1, 0, 1}));
+      EXPECT_EQ(delta.indices.back(), 5 * step);
+
+      decoder.apply(delta);
+      ASSERT_TRUE(std::equal(frame.begin(), frame.end(), decoder.frame())) << "step " << step;
+    }
+
+    encoder.encode(frame.data(), delta);
+    EXPECT_TRUE(delta.indices.empty()) << "an unchanged frame has no changed squares";
+  }
+
+  /* a logged environment's frames are read back exactly, with their agents and episode boundaries */
+  TEST(ObservationLogTest, EnvironmentLog) {
+    using GridEnvironment = agario::env::GridEnvironment<int, renderable>;
+    int num_agents = 2;
+    GridEnvironment env(num_agents, 2, 500, true, 500, 5, 5);
+    env.configure_observation(2, 32, true, true, true, true);
+    env.seed(0);
+    env.log_observations(log_file(), 4);
+
+    struct Logged { int agent; bool episode_start; std::vector<int> frame; };
+    std::vector<Logged> logged;
+    auto record = [&](bool episode_start) {
+      for (int i = 0; i < num_agents; i++) {
+        auto &obs = env.get_observations()[i];
+        int frame_length = obs.length() / obs.num_frames();
+        logged.push_back({i, episode_start, std::vector<int>(obs.newest_frame(), obs.newest_frame() + frame_length)});
+      }
+    };
+
+    std::vector<Action> actions(num_agents, Action(0.5, 0.25, agario::action::none));
+    for (int episode = 0; episode < 2; episode++) {
+      env.reset();
+      record(true);
+      for (int step = 0; step < 10; step++) {
+        env.take_actions(actions);
+        env.step();
+        record(false);
+      }
+    }
+    EXPECT_THROW(env.configure_observation(1, 32, true, true, true, true), EnvironmentException);
+    env.stop_logging();
+
+    ObservationLogReader<int> reader(log_file());
+    EXPECT_EQ(reader.channels(), env.get_observations()[0].channels_per_frame());
+    EXPECT_EQ(reader.height(), 32);
+    EXPECT_EQ(reader.width(), 32);
+
+    int deltas = 0;
+    for (auto &expected : logged) {
+      ASSERT_TRUE(reader.next());
+      auto &record = reader.record();
+      EXPECT_EQ(record.agent, expected.agent);
+      EXPECT_EQ(record.episode_start, expected.episode_start);
+      if (record.episode_start) {
+        EXPECT_TRUE(record.keyframe) << "episode did not start on a keyframe";
+      }
+      deltas += !record.keyframe;
+      ASSERT_TRUE(std::equal(expected.frame.begin(), expected.frame.end(), reader.frame()));
+    }
+    EXPECT_FALSE(reader.next());
+    EXPECT_GT(deltas, 0);
+
+    // the deltas are smaller than the frames they stand for
+    auto dense_bytes = logged.size() * logged.front().frame.size() * sizeof(int);
+    EXPECT_LT(std::filesystem::file_size(log_file()), dense_bytes);
+    std::filesystem::remove(log_file());
+  }
+
+  TEST(ObservationLogTest, WrongType) {
+    { ObservationLogWriter<int> writer(log_file(), 1, 2, 2); }
+    EXPECT_THROW(ObservationLogReader<std::uint8_t> reader(log_file()), EnvironmentException);
+    EXPECT_NO_THROW(ObservationLogReader<int> reader(log_file()));
+    std::filesystem::remove(log_file());
+  }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <environment/envs/GridEnvironment.hpp>
+#include <environment/envs/ReplayEnvironment.hpp>
+
+#include <environment/renderable.hpp>
+
+using namespace agario::env;
+
+namespace {
+
+  std::string replay_file(const std::string &name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+  }
+
+  /* plays two recorded episodes in a grid environment, with a mix of actions */
+  void play_recorded(agario::env::GridEnvironment<int, renderable> &env, const std::string &filename, int hash_interval) {
+    env.seed(7);
+    env.record_replay(filename, hash_interval);
+    for (int episode = 0; episode < 2; episode++) {
+      env.reset();
+      for (int step = 0; step < 25; step++) {
+        float angle = 0.3f * step;
+        auto action = static_cast<agario::action>(step % 7 == 6 ? agario::action::split : agario::action::none);
+        env.take_actions({Action(std::cos(angle), std::sin(angle), action)});
+        env.step();
+      }
+    }
+    env.stop_recording();
+  }
+
+  /* a replay re-runs the recorded game exactly */
+  TEST(ReplayTest, ReplaysExactly) {
+    auto filename = replay_file("agarcl-test-replay.agrp");
+    agario::env::GridEnvironment<int, renderable> env(1, 4, 1000, true, 1000, 25, 10);
+    env.configure_observation(1, 64, true, true, true, true);
+    play_recorded(env, filename, 5);
+
+    auto stats = ReplayEnvironment::replay(filename);
+    EXPECT_FALSE(stats.diverged()) << "diverged at step " << stats.diverged_step;
+    EXPECT_EQ(stats.resets, 2);
+    EXPECT_EQ(stats.steps, 50);
+    EXPECT_EQ(stats.ticks, 200);
+    EXPECT_EQ(stats.hashes_checked, 10);
+
+    // the log is much smaller than a snapshot of a single state
+    auto snapshot = replay_file("agarcl-test-replay.bin");
+    env.save_env_state(snapshot);
+    EXPECT_LT(std::filesystem::file_size(filename) * 10, std::filesystem::file_size(snapshot));
+
+    std::filesystem::remove(filename);
+    std::filesystem::remove(snapshot);
+  }
+
+  /* replays regenerate pellets and viruses as the recorded game was configured to */
+  TEST(ReplayTest, ReplaysRegenConfiguration) {
+    auto filename = replay_file("agarcl-test-replay.agrp");
+    agario::env::GridEnvironment<int, renderable> env(1, 4, 1000, true, 1000, 25, 10);
+    env.configure_observation(1, 64, true, true, true, true);
+    env.configure_regen(5, true);
+    play_recorded(env, filename, 5);
+
+    auto stats = ReplayEnvironment::replay(filename);
+    EXPECT_FALSE(stats.diverged()) << "diverged at step " << stats.diverged_step;
+    EXPECT_EQ(stats.hashes_checked, 10);
+
+    env.record_replay(filename);
+    EXPECT_THROW(env.configure_regen(0), EnvironmentException) << "regeneration changed while recording";
+    env.stop_recording();
+    std::filesystem::remove(filename);
+  }
+
+  /* replays tick on as many threads as the recorded game did */
+  TEST(ReplayTest, ReplaysThreadedGame) {
+    auto filename = replay_file("agarcl-test-replay.agrp");
+    agario::env::GridEnvironment<int, renderable> env(1, 4, 1000, true, 1000, 25, 10);
+    env.configure_observation(1, 64, true, true, true, true);
+    env.set_num_threads(4);
+    play_recorded(env, filename, 5);
+
+    auto stats = ReplayEnvironment::replay(filename);
+    EXPECT_FALSE(stats.diverged()) << "diverged at step " << stats.diverged_step;
+    EXPECT_EQ(stats.hashes_checked, 10);
+
+    env.record_replay(filename);
+    EXPECT_THROW(env.set_num_threads(1), EnvironmentException) << "threads changed while recording";
+    env.stop_recording();
+    std::filesystem::remove(filename);
+  }
+
+  /* a replay whose actions differ from the recorded game reports where it diverged */
+  TEST(ReplayTest, DetectsDivergence) {
+    auto filename = replay_file("agarcl-test-replay.agrp");
+    auto tampered = replay_file("agarcl-test-replay-tampered.agrp");
+    agario::env::GridEnvironment<int, renderable> env(1, 4, 1000, true, 1000, 25, 10);
+    env.configure_observation(1, 64, true, true, true, true);
+    play_recorded(env, filename, 5);
+
+    // copy the log, steering differently from the 12th step on
+    {
+      ReplayLogReader log(filename);
+      ReplayLogWriter out(tampered, log.header());
+      ReplayLogReader::Event event{};
+      int steps = 0;
+      while (log.next(event)) {
+        switch (event.kind) {
+          case ReplayEvent::reset: out.reset(event.rng_state); break;
+          case ReplayEvent::action: out.action(event.pid, steps >= 11 ? -event.dx : event.dx, event.dy, event.action); break;
+          case ReplayEvent::step: out.step(); steps++; break;
+          case ReplayEvent::hash: out.hash(event.state_hash); break;
+        }
+      }
+    }
+
+    auto stats = ReplayEnvironment::replay(tampered);
+    EXPECT_TRUE(stats.diverged());
+    EXPECT_EQ(stats.diverged_step, 15) << "the first hash after the change should differ";
+    EXPECT_EQ(stats.steps, 15) << "the replay should stop where it diverged";
+
+    std::filesystem::remove(filename);
+    std::filesystem::remove(tampered);
+  }
+
+  /* nothing before the first reset is recorded, and states can't be loaded mid-recording */
+  TEST(ReplayTest, RecordsFromReset) {
+    auto filename = replay_file("agarcl-test-replay.agrp");
+    agario::env::GridEnvironment<int, renderable> env(1, 4, 1000, true, 1000, 25, 10);
+    env.configure_observation(1, 64, true, true, true, true);
+    env.record_replay(filename);
+    EXPECT_TRUE(env.recording());
+    env.step();
+    EXPECT_THROW(env.load_env_state(filename), EnvironmentException);
+    env.reset();
+    env.step();
+    env.stop_recording();
+
+    auto stats = ReplayEnvironment::replay(filename);
+    EXPECT_EQ(stats.resets, 1);
+    EXPECT_EQ(stats.steps, 1);
+    std::filesystem::remove(filename);
+  }
+}
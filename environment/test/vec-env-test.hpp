@@ -0,0 +1,132 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <environment/envs/VecGridEnvironment.hpp>
+
+#include <environment/renderable.hpp>
+
+using namespace agario::env;
+
+namespace {
+
+  using VecGridEnvironment = agario::env::VecGridEnvironment<int, renderable>;
+
+  TEST(VecEnvTest, ObservationShape) {
+    VecGridEnvironment env(3, 2, 2, 500, false, 50, 0, 0);
+    env.configure_observation(2, 16, true, true, true, true);
+
+    auto [n, channels, height, width] = env.observation_shape();
+    auto single = env.env(0).observation_shape();
+    EXPECT_EQ(n, 3);
+    EXPECT_EQ(channels, std::get<0>(single));
+    EXPECT_EQ(height, 16);
+    EXPECT_EQ(width, 16);
+  }
+
+  TEST(VecEnvTest, BadNumEnvs) {
+    EXPECT_THROW(VecGridEnvironment(0, 1, 2, 500, false, 50, 0, 0), EnvironmentException);
+    EXPECT_THROW(VecGridEnvironment(-1, 1, 2, 500, false, 50, 0, 0), EnvironmentException);
+  }
+
+  /* a step's observations stay untouched through the following step, and outlive reconfiguring */
+  TEST(VecEnvTest, ObservationBuffersOutliveStep) {
+    VecGridEnvironment env(2, 1, 2, 500, false, 100, 0, 0);
+    env.configure_observation(1, 16, true, true, true, true);
+    env.reset();
+
+    std::vector<float> actions = {1, 0, 0, 0, 1, 0};
+    env.step(actions.data());
+    auto held = env.observation_buffer();
+    auto copy = *held;
+    env.step(actions.data());
+    EXPECT_NE(held, env.observation_buffer());
+    EXPECT_EQ(*held, copy) << "the following step overwrote the held observations";
+
+    env.configure_observation(1, 8, true, true, true, true);
+    EXPECT_EQ(*held, copy);
+    EXPECT_EQ(env.observation_buffer()->size(), held->size() / 4);
+  }
+
+  /* stepping the batch on several threads fills in each environment's slice of the batch */
+  TEST(VecEnvTest, StepFillsBatch) {
+    constexpr int num_envs = 5;
+    VecGridEnvironment vec(num_envs, 3, 2, 500, false, 100, 0, 0);
+    vec.configure_observation(1, 32, true, true, true, true);
+    vec.seed(7);
+    vec.reset();
+
+    std::vector<float> actions(3 * num_envs);
+    for (int step = 0; step < 10; step++) {
+      for (int i = 0; i < num_envs; i++) {
+        actions[3 * i] = (i % 2) ? 0.5 : -0.5;
+        actions[3 * i + 1] = (step % 3) ? 0.25 : -1;
+        actions[3 * i + 2] = 0;
+      }
+      vec.step(actions.data());
+
+      for (int i = 0; i < num_envs; i++) {
+        auto &obs = vec.env(i).get_observations().front();
+        const int *batch = vec.observations() + i * obs.length();
+        ASSERT_TRUE(std::equal(obs.data(), obs.data() + obs.length(), batch)) << "env " << i << " step " << step;
+        ASSERT_FALSE(vec.dones()[i]);
+      }
+    }
+  }
+
+  /* seeded batches play out exactly like standalone environments with the same seeds */
+  TEST(VecEnvTest, MatchesSerialEnvironments) {
+    using GridEnvironment = agario::env::GridEnvironment<int, renderable>;
+    constexpr int num_envs = 4;
+    VecGridEnvironment vec(num_envs, 3, 2, 500, false, 100, 5, 3);
+    vec.configure_observation(1, 32, true, true, true, true);
+    vec.seed(7);
+    vec.reset();
+
+    std::vector<std::unique_ptr<GridEnvironment>> envs;
+    for (int i = 0; i < num_envs; i++) {
+      envs.emplace_back(std::make_unique<GridEnvironment>(1, 2, 500, false, 100, 5, 3));
+      envs.back()->configure_observation(1, 32, true, true, true, true);
+      envs.back()->seed(7 + i);
+      envs.back()->reset();
+    }
+
+    std::vector<float> actions(3 * num_envs);
+    for (int step = 0; step < 20; step++) {
+      for (int i = 0; i < num_envs; i++) {
+        actions[3 * i] = (i % 2) ? 0.5 : -0.5;
+        actions[3 * i + 1] = (step % 3) ? 0.25 : -1;
+        actions[3 * i + 2] = 0;
+      }
+      vec.step(actions.data());
+
+      for (int i = 0; i < num_envs; i++) {
+        auto &env = *envs[i];
+        env.take_actions({Action(actions[3 * i], actions[3 * i + 1], agario::action::none)});
+        ASSERT_EQ(vec.rewards()[i], env.step().front()) << "env " << i << " step " << step;
+
+        auto &obs = env.get_observations().front();
+        const int *batch = vec.observations() + i * obs.length();
+        ASSERT_TRUE(std::equal(obs.data(), obs.data() + obs.length(), batch)) << "env " << i << " step " << step;
+      }
+    }
+  }
+
+  /* episodes are truncated after max_steps and the environments are reset automatically */
+  TEST(VecEnvTest, TruncationResets) {
+    VecGridEnvironment env(2, 2, 1, 500, false, 50, 0, 0, 0, 0, 0, 3);
+    env.configure_observation(1, 16, true, true, true, true);
+    env.reset();
+
+    std::vector<float> actions(6, 0);
+    for (int episode = 0; episode < 2; episode++) {
+      for (int step = 1; step <= 3; step++) {
+        env.step(actions.data());
+        for (int i = 0; i < env.num_envs(); i++) {
+          EXPECT_FALSE(env.dones()[i]);
+          EXPECT_EQ(static_cast<bool>(env.truncations()[i]), step == 3);
+        }
+      }
+    }
+  }
+
+}
@@ -39,10 +39,42 @@ import gymnasium as gym
 from gymnasium import spaces
 import numpy as np
 import cv2
+import copy
 import os
 import agarcl
 from .agar_utils import get_color_array, Color
 import random
+
+# dtypes of grid observations, and the suffix of the agarcl classes that produce them. int32
+# observations hold raw masses; the others are quantized per channel: "at least one" channels are
+# 0/1 masks, pellet channels are counts and mass channels are masses divided by `mass_scale`
+grid_dtypes = {
+    np.dtype(np.int32):   "",
+    np.dtype(np.uint16):  "UInt16",
+    np.dtype(np.uint8):   "UInt8",
+    np.dtype(np.float16): "Float16",
+}
+
+
+def grid_environment_class(dtype, vectorized=False):
+    """ the agarcl (vectorized) grid environment class with observations of type `dtype` """
+    dtype = np.dtype(dtype)
+    if dtype not in grid_dtypes:
+        raise ValueError(f"Unsupported grid observation dtype: {dtype}")
+    name = "VecGridEnvironment" if vectorized else "GridEnvironment"
+    return getattr(agarcl, name + grid_dtypes[dtype])
+
+
+def grid_observation_space(shape, dtype):
+    """ observation space of grid observations of type `dtype` (out-of-bounds squares
+    are -1, or 1 in unsigned dtypes) """
+    dtype = np.dtype(dtype)
+    if dtype.kind == 'f':
+        return spaces.Box(-1, np.finfo(dtype).max, shape, dtype=dtype)
+    low = 0 if dtype.kind == 'u' else -1
+    return spaces.Box(low, np.iinfo(dtype).max, shape, dtype=dtype)
+
+
 class AgarioEnv(gym.Env):
     metadata = {'render_modes': ['human','rgb_array'], 'render_fps': 60}
 
@@ -146,12 +178,79 @@ class AgarioEnv(gym.Env):
             if self.obs_type == "grid":
                 return  self._env.get_frame()
 
+    def profile(self):
+        """ per-phase tick timings and counters of the underlying engine(s)
+        (an empty dict unless agarcl was built with -DPROFILE=ON)
+        """
+        return self._env.profile()
+
+    def set_num_threads(self, num_threads):
+        """ ticks the players of each game tick on `num_threads` threads, which pays off
+        in arenas with many bots. Games play out the same on any number of threads above
+        one, but differently from games on a single thread (clones keep the number of
+        threads, and replays record it, so it can't be changed while recording).
+        """
+        self._env.set_num_threads(num_threads)
+
+    def configure_regen(self, budget, low_discrepancy=False):
+        """ regrows at most `budget` pellets and viruses per tick (0 for no limit), so that the
+        regrowth owed every 120 ticks is spread over the following ticks instead of landing on one.
+        With `low_discrepancy`, pellets and viruses are placed more evenly from the next reset on.
+        """
+        self._env.configure_regen(budget, low_discrepancy)
+
     def load_env_state(self, filename):
+        """ restores a state saved by save_env_state (either a binary snapshot or JSON) """
         self._env.load_env_state(filename)
 
     def save_env_state(self, filename):
+        """ saves the state as JSON if `filename` ends in .json, or else as a binary snapshot """
         self._env.save_env_state(filename)
 
+    def clone(self):
+        """ an in-memory copy of the environment that plays out exactly as this one would
+        (bots, RNG state and observations included), e.g. to branch the game in tree search.
+        Only grid environments can be cloned. The copy doesn't record videos or log observations.
+        """
+        if self.obs_type != "grid":
+            raise ValueError("Only grid environments can be cloned")
+        env = copy.copy(self)
+        env._env = self._env.clone()
+        env.video_recorder = []
+        env.video_recorder_enabled = False
+        return env
+
+    def copy_state_from(self, other):
+        """ makes this environment a copy of `other` (a clone of it, or of the same configuration),
+        reusing its memory: the cheap way to return to a branch point many times
+        """
+        self._env.copy_state_from(other._env)
+        self.steps = other.steps
+
+    def log_observations(self, filename, keyframe_interval=100):
+        """ logs the newest grid frame of every agent on every reset and step to `filename`,
+        delta-encoded with a dense keyframe every `keyframe_interval` frames
+        (read it back with gym_agario.observation_log.read_observation_log)
+        """
+        if self.obs_type != "grid":
+            raise ValueError("Only grid observations can be logged")
+        self._env.log_observations(filename, keyframe_interval)
+
+    def stop_logging(self):
+        self._env.stop_logging()
+
+    def record_replay(self, filename, hash_interval=0):
+        """ records the seed and actions of every episode from the next reset on to `filename`,
+        with a hash of the game every `hash_interval` steps (0 for none), so that it can be
+        re-run headless and checked with agarcl.replay(filename)
+        """
+        if self.obs_type == "screen":
+            raise ValueError("Screen environments can't be replayed")
+        self._env.record_replay(filename, hash_interval)
+
+    def stop_recording(self):
+        self._env.stop_recording()
+
     def close(self):
         self._env.close()
 
@@ -223,13 +322,16 @@ class AgarioEnv(gym.Env):
                 'observe_pellets': True,
                 'c_death': 0,
             }
-            env = agarcl.GridEnvironment(*args)
+            dtype = np.dtype(kwargs.get("dtype", np.int32))
+            env = grid_environment_class(dtype)(*base_args)
             env.configure_observation(kwargs | grid_defaults)
+            # hand out views of double-buffered observations instead of copies;
+            # each observation stays unchanged through the step following the one that returned it
+            env.set_double_buffered(kwargs.get("zero_copy", False))
 
             channels, width, height = env.observation_shape()
             shape = (width, height, channels)
-            dtype = np.int32
-            observation_space = spaces.Box(-1, np.iinfo(dtype).max, shape, dtype=dtype)
+            observation_space = grid_observation_space(shape, dtype)
 
         elif obs_type == "screen":
             if not agarcl.has_screen_env:
@@ -0,0 +1,139 @@
+"""
+This file wraps the batched grid environment (agarcl.VecGridEnvironment)
+in a gymnasium VectorEnv interface. All of the environments in the batch
+are stepped by a single call into C++, which spreads them over a pool of
+worker threads with the GIL released and writes their observations into one
+(N, C, H, W) buffer.
+
+Each environment in the batch holds a single agent. Environments whose episode
+ended (terminated or truncated) are reset automatically during `step()`, in which
+case the returned observation is the first one of the new episode and the last
+observation of the finished one is in `infos["final_observation"]`, as in the
+gymnasium vector environments.
+
+Observations are returned as copies by default. With `zero_copy=True` they are
+read-only views of the batch buffers instead, which stay valid through the
+following step, as with a grid AgarioEnv.
+"""
+import gymnasium as gym
+from gymnasium import spaces
+import numpy as np
+import agarcl
+from gym_agario.AgarioEnv import grid_environment_class, grid_observation_space
+
+
+class VecAgarioEnv(gym.vector.VectorEnv):
+    metadata = {'render_modes': [], 'autoreset': True}
+
+    def __init__(self, num_envs, num_threads=None, **kwargs):
+        """
+        :param num_envs: number of environments in the batch
+        :param num_threads: number of worker threads to step them with (defaults to one per environment)
+        :param kwargs: the same configuration as a grid AgarioEnv
+        """
+        if num_threads is None:
+            num_threads = num_envs
+
+        self.ticks_per_step  = kwargs.get("ticks_per_step", 4)
+        self.arena_size      = kwargs.get("arena_size", 1000)
+        self.pellet_regen    = kwargs.get("pellet_regen", True)
+        self.num_pellets     = kwargs.get("num_pellets", 1000)
+        self.num_viruses     = kwargs.get("num_viruses", 0)
+        self.num_bots        = kwargs.get("num_bots", 0)
+        self.reward_type     = kwargs.get("reward_type", 1)
+        self.c_death         = kwargs.get("c_death", 0)
+        self.mode            = kwargs.get("mode", 0)
+        self.number_of_steps = kwargs.get("number_steps", 500)
+        self.env_type        = kwargs.get("env_type", 0)  # 0 -> Episodic or 1 -> Continuing
+        self.zero_copy       = kwargs.get("zero_copy", False)
+
+        if type(self.ticks_per_step) is not int or self.ticks_per_step <= 0:
+            raise ValueError(f"ticks_per_step must be a positive integer")
+
+        max_steps = self.number_of_steps if self.env_type == 0 else 0
+        dtype = np.dtype(kwargs.get("dtype", np.int32))
+        VecGridEnvironment = grid_environment_class(dtype, vectorized=True)
+        self._env = VecGridEnvironment(num_envs, num_threads, self.ticks_per_step, self.arena_size,
+                                              self.pellet_regen, self.num_pellets, self.num_viruses,
+                                              self.num_bots, self.reward_type, self.c_death, self.mode,
+                                              max_steps)
+
+        grid_config = {
+            'num_frames': kwargs.get("num_frames", 1),
+            'grid_size': kwargs.get("grid_size", 128),
+            'observe_cells': kwargs.get("observe_cells", True),
+            'observe_others': kwargs.get("observe_others", True),
+            'observe_viruses': kwargs.get("observe_viruses", True),
+            'observe_pellets': kwargs.get("observe_pellets", True),
+            'mass_scale': kwargs.get("mass_scale"),
+        }
+        self._env.configure_observation(grid_config)
+
+        _, channels, height, width = self._env.observation_shape()
+        observation_space = grid_observation_space((channels, height, width), dtype)
+        action_space = spaces.Tuple((
+            # (dx, dy) movemment vector
+            spaces.Box(low=-1, high=1, shape=(2,)),
+            # 0=noop  1=split  2=feed
+            spaces.Discrete(3),
+        ))
+        super().__init__(num_envs, observation_space, action_space)
+
+    def reset(self, *, seed=None, options=None):
+        """ resets every environment in the batch
+        :param seed: if given, environment i is seeded with `seed + i`
+        :return: (N, C, H, W) observations, and an empty info dict
+        """
+        if seed is not None:
+            self._env.seed(seed)
+        self._env.reset()
+        return self._observations(self._env.get_state()), {}
+
+    def step(self, actions):
+        """ takes one action in, and steps, every environment in the batch
+        :param actions: either an (N, 3) array of (dx, dy, a) rows, or a batched
+            action from `action_space`: a tuple of an (N, 2) target array and N game actions
+        :return: observations, rewards, terminations, truncations and infos, batched over environments
+        """
+        observations, rewards, terminations, truncations = self._env.step(self._batch_actions(actions))
+
+        infos = {}
+        ended = terminations | truncations
+        if ended.any():
+            final_observations = self._observations(self._env.final_observations())
+            infos["final_observation"] = np.array([obs if end else None
+                                                   for obs, end in zip(final_observations, ended)], dtype=object)
+            infos["_final_observation"] = ended
+        return self._observations(observations), rewards, terminations, truncations, infos
+
+    def seed(self, seed=None):
+        if seed is not None:
+            self._env.seed(seed)
+            return [seed + i for i in range(self.num_envs)]
+
+    def configure_regen(self, budget, low_discrepancy=False):
+        """ spreads the regrowth of pellets and viruses over ticks in every environment
+        (see AgarioEnv.configure_regen)
+        """
+        self._env.configure_regen(budget, low_discrepancy)
+
+    def profile(self):
+        """ per-phase tick timings and counters of the underlying engine(s)
+        (an empty dict unless agarcl was built with -DPROFILE=ON)
+        """
+        return self._env.profile()
+
+    def _observations(self, observations):
+        return observations if self.zero_copy else observations.copy()
+
+    def _batch_actions(self, actions):
+        if isinstance(actions, tuple):
+            targets, game_actions = actions
+            targets = np.asarray(targets, dtype=np.float32).reshape(self.num_envs, 2)
+            game_actions = np.asarray(game_actions, dtype=np.float32).reshape(self.num_envs, 1)
+            actions = np.concatenate((targets, game_actions), axis=1)
+
+        actions = np.asarray(actions, dtype=np.float32)
+        if actions.shape != (self.num_envs, 3):
+            raise ValueError(f"Actions must have shape ({self.num_envs}, 3), got {actions.shape}")
+        return np.ascontiguousarray(actions)
@@ -21,3 +21,5 @@ if agarcl.has_screen_env:
 register(id='agario-gobigger-v0',
             entry_point='gym_agario.AgarioEnv:AgarioEnv',
             kwargs={'obs_type': 'gobigger'})
+
+from gym_agario.VecAgarioEnv import VecAgarioEnv
@@ -0,0 +1,51 @@
+"""
+Reader for the observation logs written by AgarioEnv.log_observations
+(see environment/envs/observation_log.hpp for the file format).
+"""
+import numpy as np
+
+_header = np.dtype([("magic", "S4"), ("version", "<u4"), ("dtype", "S4"), ("channels", "<u4"),
+                    ("height", "<u4"), ("width", "<u4"), ("keyframe_interval", "<u4"), ("reserved", "<u4")])
+
+_record = np.dtype([("kind", "u1"), ("flags", "u1"), ("agent", "<u2"), ("step", "<u4"), ("size", "<u4")])
+
+
+def read_observation_log(filename):
+    """ yields a dict of (agent, step, episode_start, keyframe, frame) for every record of
+    the observation log `filename`, where frame is the dense (C, H, W) frame. The frames
+    are copies, so they may be kept.
+    """
+    data = np.fromfile(filename, dtype=np.uint8)
+    header = data[:_header.itemsize].view(_header)[0]
+    if header["magic"] != b"AGOL" or header["version"] != 1:
+        raise ValueError(f"{filename} is not an observation log")
+
+    dtype = np.dtype(header["dtype"].decode())
+    channels, height, width = int(header["channels"]), int(header["height"]), int(header["width"])
+    shape = (channels, height, width)
+    frames = {}  # latest frame of each agent, flattened per channel
+
+    offset = _header.itemsize
+    while offset < len(data):
+        record = data[offset:offset + _record.itemsize].view(_record)[0]
+        offset += _record.itemsize
+        payload = data[offset:offset + int(record["size"])]
+        offset += int(record["size"])
+
+        agent = int(record["agent"])
+        keyframe = record["kind"] == 0
+        if keyframe:
+            frames[agent] = payload.view(dtype).reshape(channels, height * width).copy()
+        else:
+            counts = payload[:4 * channels].view("<u4")
+            changed = int(counts.sum())
+            indices = payload[4 * channels:4 * (channels + changed)].view("<u4")
+            values = payload[4 * (channels + changed):].view(dtype)
+            rows = np.repeat(np.arange(channels), counts)
+            frames[agent][rows, indices] = values
+
+        yield {"agent": agent,
+               "step": int(record["step"]),
+               "episode_start": bool(record["flags"] & 1),
+               "keyframe": bool(keyframe),
+               "frame": frames[agent].reshape(shape).copy()}
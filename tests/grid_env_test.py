@@ -117,6 +117,118 @@ class GridGymTest(unittest.TestCase):
                             if done: break
                             self._assertCorrectShape(env, s)
 
+    def test_compact_dtypes(self):
+        """ tests that compact observations have the same layout as int32 ones,
+        with "at least one" channels as masks and unsigned out-of-bounds squares as 1
+        """
+        int_env = gym.make(env_name, **default_config)
+        int_env.unwrapped.seed(0)
+        int_state, _ = int_env.reset()
+
+        for dtype in (np.uint16, np.uint8, np.float16):
+            env = gym.make(env_name, dtype=dtype, **default_config)
+            self.assertEqual(env.observation_space.dtype, dtype)
+
+            env.unwrapped.seed(0)
+            state, _ = env.reset()
+            self.assertEqual(state.dtype, dtype)
+            self.assertEqual(state.shape, int_state.shape)
+            self.assertTrue(state in env.observation_space)
+            np.testing.assert_array_equal(state != 0, int_state != 0)
+            # channels: out-of-bounds, any pellets, ...
+            self.assertTrue(np.all(state[..., 1] <= 1))
+            if np.dtype(dtype).kind == 'u':
+                self.assertTrue(np.all(state[..., 0] <= 1))
+
+    def test_observation_log(self):
+        """ tests that logged observations are read back as the newest frames that were observed
+        """
+        import os, tempfile
+        from gym_agario.observation_log import read_observation_log
+
+        env = gym.make(env_name, **default_config)
+        filename = os.path.join(tempfile.mkdtemp(), "observations.agol")
+        env.unwrapped.log_observations(filename, keyframe_interval=4)
+
+        state, _ = env.reset()
+        observed = [state]
+        for _ in range(10):
+            state, _, _, _, _ = env.step(null_action)
+            observed.append(state)
+        env.unwrapped.stop_logging()
+
+        records = list(read_observation_log(filename))
+        self.assertEqual(len(records), len(observed))
+        self.assertTrue(records[0]["episode_start"] and records[0]["keyframe"])
+        self.assertTrue(any(not record["keyframe"] for record in records))
+        for record, state in zip(records, observed):
+            # observations are (H, W, C), with the newest frame's channels last
+            newest = state[..., -record["frame"].shape[0]:]
+            np.testing.assert_array_equal(record["frame"], np.moveaxis(newest, -1, 0))
+        os.remove(filename)
+
+    def test_clone(self):
+        """ tests that a cloned environment steps exactly as the original does,
+        and that copying its state back into it returns it to the branch point
+        """
+        env = gym.make(env_name, **default_config)
+        env.unwrapped.seed(0)
+        env.reset()
+        for _ in range(5):
+            env.step(null_action)
+
+        fork = env.unwrapped.clone()
+        for _ in range(5):
+            state, reward, _, _, _ = env.step(null_action)
+            fork_state, fork_reward, _, _, _ = fork.step(null_action)
+            np.testing.assert_array_equal(state, fork_state)
+            self.assertEqual(reward, fork_reward)
+
+        branch_point = env.unwrapped.clone()
+        fork.step(((1, 1), 1))
+        fork.copy_state_from(branch_point)
+        np.testing.assert_array_equal(env.step(null_action)[0], fork.step(null_action)[0])
+
+    def test_replay(self):
+        """ tests that a recorded game replays exactly """
+        import os, tempfile
+        import agarcl
+
+        env = gym.make(env_name, **default_config)
+        filename = os.path.join(tempfile.mkdtemp(), "game.agrp")
+        env.unwrapped.seed(0)
+        env.unwrapped.record_replay(filename, hash_interval=5)
+        env.reset()
+        for i in range(20):
+            env.step(((np.cos(i), np.sin(i)), 0))
+        env.unwrapped.stop_recording()
+
+        stats = agarcl.replay(filename)
+        self.assertFalse(stats["diverged"])
+        self.assertEqual(stats["steps"], 20)
+        self.assertEqual(stats["hashes_checked"], 4)
+        os.remove(filename)
+
+    def test_regen_budget(self):
+        """ tests that games with spread-out regrowth still replay exactly """
+        import os, tempfile
+        import agarcl
+
+        env = gym.make(env_name, **default_config)
+        env.unwrapped.configure_regen(10, low_discrepancy=True)
+        filename = os.path.join(tempfile.mkdtemp(), "game.agrp")
+        env.unwrapped.seed(0)
+        env.unwrapped.record_replay(filename, hash_interval=5)
+        env.reset()
+        for i in range(40):
+            state, reward, done, truncated, info = env.step(((np.cos(i), np.sin(i)), 0))
+            self._assertValidState(env, state)
+        env.unwrapped.stop_recording()
+
+        stats = agarcl.replay(filename)
+        self.assertFalse(stats["diverged"])
+        os.remove(filename)
+
     def _assertValidState(self, env, state):
         """ asserts that the state which was returned by a `reset` or `step` from the
         environment `env` is well-formed. Checks the type, data type, shape, and values
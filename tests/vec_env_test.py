@@ -0,0 +1,80 @@
+#!/usr/bin/env python
+
+import gymnasium as gym
+import gym_agario
+import numpy as np
+
+import unittest
+
+from tests import default_config
+
+
+class VecGymTest(unittest.TestCase):
+
+    num_envs = 4
+
+    def test_creation(self):
+        """ tests that the vectorized environment is a gymnasium VectorEnv """
+        env = gym_agario.VecAgarioEnv(self.num_envs, **default_config)
+        self.assertIsInstance(env, gym.vector.VectorEnv)
+        self.assertEqual(env.num_envs, self.num_envs)
+
+    def test_steps(self):
+        """ tests that stepping the batch returns batched, well-formed values """
+        env = gym_agario.VecAgarioEnv(self.num_envs, **default_config)
+        obs, info = env.reset(seed=0)
+        self.assertEqual(obs.shape, (self.num_envs,) + env.single_observation_space.shape)
+
+        actions = np.zeros((self.num_envs, 3), dtype=np.float32)
+        for _ in range(16):
+            obs, rewards, terminations, truncations, infos = env.step(actions)
+            self.assertEqual(obs.shape, (self.num_envs,) + env.single_observation_space.shape)
+            self.assertEqual(rewards.shape, (self.num_envs,))
+            self.assertEqual(terminations.dtype, bool)
+            self.assertEqual(truncations.dtype, bool)
+            self.assertIsInstance(infos, dict)
+            for o in obs:
+                self.assertTrue(o in env.single_observation_space)
+
+    def test_autoreset(self):
+        """ tests that truncated environments report their final observation """
+        env = gym_agario.VecAgarioEnv(self.num_envs, number_steps=3, **default_config)
+        env.reset()
+        actions = np.zeros((self.num_envs, 3), dtype=np.float32)
+        for _ in range(3):
+            _, _, _, truncations, infos = env.step(actions)
+        self.assertTrue(truncations.all())
+        self.assertTrue(infos["_final_observation"].all())
+
+    def test_compact_dtypes(self):
+        """ tests that compact observation dtypes are returned as the matching NumPy types """
+        for dtype in (np.uint16, np.uint8, np.float16):
+            env = gym_agario.VecAgarioEnv(self.num_envs, dtype=dtype, **default_config)
+            obs, _ = env.reset(seed=0)
+            self.assertEqual(obs.dtype, dtype)
+            obs, *_ = env.step(np.zeros((self.num_envs, 3), dtype=np.float32))
+            self.assertEqual(obs.dtype, dtype)
+            for o in obs:
+                self.assertTrue(o in env.single_observation_space)
+
+    def test_zero_copy(self):
+        """ tests that zero-copy observations are read-only views that survive the following step """
+        env = gym_agario.VecAgarioEnv(self.num_envs, zero_copy=True, **default_config)
+        env.reset(seed=0)
+        actions = np.ones((self.num_envs, 3), dtype=np.float32)
+        obs, *_ = env.step(actions)
+        self.assertFalse(obs.flags.writeable)
+        held = obs.copy()
+        env.step(actions)
+        np.testing.assert_array_equal(obs, held)
+
+    def test_bad_actions(self):
+        """ tests that actions of the wrong shape are rejected """
+        env = gym_agario.VecAgarioEnv(self.num_envs, **default_config)
+        env.reset()
+        with self.assertRaises(ValueError):
+            env.step(np.zeros((self.num_envs + 1, 3)))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -7,7 +7,12 @@
 #include <iostream>
 
 ThreadPool::ThreadPool(size_t num_threads) :
-  workers(num_threads), num_threads(num_threads), should_exit(false) {
+  workers(num_threads), num_threads(num_threads), should_exit(false),
+  free_workers(num_threads, false), worker_funcs(num_threads) {
+
+  // the worker state must all exist before any thread starts reading it
+  for (id_t wid = 0; wid < num_threads; wid++)
+    worker_go.emplace_back(std::make_shared<semaphore>());
 
   // make a dispatcher thread
   dispatcher = std::thread([this]() {
@@ -16,10 +21,6 @@ ThreadPool::ThreadPool(size_t num_threads) :
 
   // make all the worker threads
   for (id_t wid = 0; wid < num_threads; wid++) {
-    free_workers.emplace_back(false);
-    worker_go.emplace_back(std::make_shared<semaphore>());
-    worker_funcs.emplace_back();
-
     workers[wid] = std::thread([this](size_t worker_id) {
       worker(worker_id);
     }, wid);